@@ -1,11 +1,20 @@
 #version 330 core
+#include "lighting.glsl"
+
 out vec4 FragColor;
 
 in vec2 TexCoords;
+in vec3 FragPos;
+in vec3 Normal;
 
 uniform sampler2D texture_diffuse1;
 
 void main()
 {    
-    FragColor = texture(texture_diffuse1, TexCoords);
+    vec4 albedo = texture(texture_diffuse1, TexCoords);
+    vec3 N = normalize(Normal);
+    float diff = max(dot(N, -sunDirection.xyz), 0.0);
+    float shadow = diff > 0.0 ? sunShadow(FragPos, N) : 1.0;
+    vec3 light = sunColor.rgb * (sunColor.w + diff * shadow) + pointLights(FragPos, N);
+    FragColor = vec4(albedo.rgb * light, albedo.a);
 }
@@ -8,34 +8,74 @@ layout(location = 4) in vec3 bitangent;
 layout(location = 5) in ivec4 boneIds; 
 layout(location = 6) in vec4 weights;
 
-uniform mat4 projection;
-uniform mat4 view;
-uniform mat4 model;
-
-const int MAX_BONES = 100;
 const int MAX_BONE_INFLUENCE = 4;
-uniform mat4 finalBonesMatrices[MAX_BONES];
+
+// per-frame and per-draw data, streamed through the ring buffer
+layout(std140) uniform FrameData {
+    mat4 projection;
+    mat4 view;
+    vec4 viewPos;
+    vec4 lightPos;
+};
+
+// skin.x = first palette texel, skin.y = texels per instance (0 = not instanced),
+// skin.z = bone count (0 = rigid, no skinning)
+layout(std140) uniform ObjectData {
+    mat4 model;
+    ivec4 skin;
+};
+
+// Bones packed as 3x4 matrices: three RGBA32F texels, one per row.
+// For instanced draws each instance block starts with its world transform.
+uniform samplerBuffer bonePalette;
 
 out vec2 TexCoords;
+out vec3 FragPos;
+out vec3 Normal;
 
 void main()
 {
-    vec4 totalPosition = vec4(0.0f);
-    for(int i = 0 ; i < MAX_BONE_INFLUENCE ; i++)
-    {
-        if(boneIds[i] == -1) 
-            continue;
-        if(boneIds[i] >=MAX_BONES) 
+    int base = skin.x;
+    mat4 world = model;
+    if (skin.y > 0) {
+        base += gl_InstanceID * skin.y;
+        mat4 inst = transpose(mat4(texelFetch(bonePalette, base),
+                                   texelFetch(bonePalette, base + 1),
+                                   texelFetch(bonePalette, base + 2),
+                                   vec4(0.0, 0.0, 0.0, 1.0)));
+        world = model * inst;
+        base += 3;
+    }
+
+    vec4 p = vec4(pos, 1.0f);
+    vec3 totalPosition = pos;
+    vec3 totalNormal = norm;
+    if (skin.z > 0) {
+        vec4 row0 = vec4(0.0f);
+        vec4 row1 = vec4(0.0f);
+        vec4 row2 = vec4(0.0f);
+        for(int i = 0 ; i < MAX_BONE_INFLUENCE ; i++)
         {
-            totalPosition = vec4(pos,1.0f);
-            break;
+            if(boneIds[i] == -1) 
+                continue;
+            if(boneIds[i] >= skin.z) 
+            {
+                row0 = vec4(1.0f, 0.0f, 0.0f, 0.0f);
+                row1 = vec4(0.0f, 1.0f, 0.0f, 0.0f);
+                row2 = vec4(0.0f, 0.0f, 1.0f, 0.0f);
+                break;
+            }
+            int texel = base + boneIds[i] * 3;
+            row0 += texelFetch(bonePalette, texel) * weights[i];
+            row1 += texelFetch(bonePalette, texel + 1) * weights[i];
+            row2 += texelFetch(bonePalette, texel + 2) * weights[i];
         }
-        vec4 localPosition = finalBonesMatrices[boneIds[i]] * vec4(pos,1.0f);
-        totalPosition += localPosition * weights[i];
-        vec3 localNormal = mat3(finalBonesMatrices[boneIds[i]]) * norm;
-   }
-	
-    mat4 viewModel = view * model;
-    gl_Position =  projection * viewModel * totalPosition;
+        totalPosition = vec3(dot(row0, p), dot(row1, p), dot(row2, p));
+        totalNormal = vec3(dot(row0.xyz, norm), dot(row1.xyz, norm), dot(row2.xyz, norm));
+    }
+
+    FragPos = vec3(world * vec4(totalPosition, 1.0f));
+    Normal = mat3(transpose(inverse(world))) * totalNormal;
+    gl_Position = projection * view * vec4(FragPos, 1.0f);
 	TexCoords = tex;
 }
@@ -0,0 +1,143 @@
+#ifndef CAMERA_RIG_H
+#define CAMERA_RIG_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <cmath>
+
+// Gribb/Hartmann plane extraction; planes point inwards, (xyz = normal, w = distance)
+inline void ExtractFrustumPlanes(const glm::mat4& viewProj, glm::vec4 planes[6]) {
+    glm::vec4 row0(viewProj[0][0], viewProj[1][0], viewProj[2][0], viewProj[3][0]);
+    glm::vec4 row1(viewProj[0][1], viewProj[1][1], viewProj[2][1], viewProj[3][1]);
+    glm::vec4 row2(viewProj[0][2], viewProj[1][2], viewProj[2][2], viewProj[3][2]);
+    glm::vec4 row3(viewProj[0][3], viewProj[1][3], viewProj[2][3], viewProj[3][3]);
+
+    planes[0] = row3 + row0;  // left
+    planes[1] = row3 - row0;  // right
+    planes[2] = row3 + row1;  // bottom
+    planes[3] = row3 - row1;  // top
+    planes[4] = row3 + row2;  // near
+    planes[5] = row3 - row2;  // far
+    for (int i = 0; i < 6; ++i)
+        planes[i] = planes[i] / glm::length(glm::vec3(planes[i]));
+}
+
+inline bool SphereInFrustum(const glm::vec4 planes[6], const glm::vec3& center, float radius) {
+    for (int i = 0; i < 6; ++i)
+        if (glm::dot(glm::vec3(planes[i]), center) + planes[i].w < -radius) return false;
+    return true;
+}
+
+// Box is outside when its most-inward corner is behind any plane
+inline bool AabbInFrustum(const glm::vec4 planes[6], const glm::vec3& mn, const glm::vec3& mx) {
+    for (int i = 0; i < 6; ++i) {
+        glm::vec3 p(planes[i].x >= 0.0f ? mx.x : mn.x, planes[i].y >= 0.0f ? mx.y : mn.y, planes[i].z >= 0.0f ? mx.z : mn.z);
+        if (glm::dot(glm::vec3(planes[i]), p) + planes[i].w < 0.0f) return false;
+    }
+    return true;
+}
+
+// Discrete LOD choice from an object's projected size, shared by the game's ModelLod and the
+// GL-free draw-list code. LOD i is used while the projected radius is at least
+// pixelThresholds[i] pixels and the LOD exists; below the last one the impostor is.
+struct ScreenSizeLod {
+    static const int MAX_LODS = 3;
+    static const int IMPOSTOR = MAX_LODS;
+
+    float pixelThresholds[MAX_LODS] = { 40.0f, 14.0f, 4.0f };
+    float lodBias = 1.0f;        // > 1 switches to coarser LODs earlier
+    glm::vec3 center{ 0.0f };    // bounding sphere in model space
+    float radius = 1.0f;
+    unsigned int available = 0;  // bit i set when LOD i has geometry
+
+    // radius in pixels = r / (d * tan(fov/2)) * height/2
+    int select(const glm::vec3& worldCenter, const glm::vec3& eye, float tanHalfFov, float viewportHeight) const {
+        float dist = glm::length(worldCenter - eye);
+        if (dist < 1e-3f) return 0;
+        float pixels = radius / (dist * tanHalfFov) * (viewportHeight * 0.5f) / lodBias;
+        for (int i = 0; i < MAX_LODS; ++i)
+            if (pixels >= pixelThresholds[i] && (available & (1u << i))) return i;
+        return IMPOSTOR;
+    }
+};
+
+struct CameraLens {
+    float fovY = glm::radians(50.0f);
+    float aspect = 16.0f / 9.0f;
+    float zNear = 0.1f;
+    float zFar = 600.0f;
+};
+
+// Everything culling and rendering need from the camera for one frame. Built once after
+// the simulation tick and only read afterwards.
+struct CameraSnapshot {
+    glm::vec3 position{ 0.0f };
+    glm::vec3 target{ 0.0f };
+    CameraLens lens;
+    float tanHalfFov = 0.0f;
+    glm::mat4 view{ 1.0f };
+    glm::mat4 projection{ 1.0f };
+    glm::mat4 viewProj{ 1.0f };
+    glm::vec4 frustumPlanes[6];
+};
+
+// Chase camera behind the runner. Smoothing is exponential (alpha = 1 - exp(-rate * dt)),
+// so it converges at the same speed at any frame rate and never overshoots, even when
+// dt * rate > 1 at low FPS and high game speed.
+class CameraRig {
+public:
+    float followRate = 5.0f;    // 1/s, position and look-at point
+    float turnRate = 8.0f;      // 1/s, yaw
+    float distance = 6.5f;
+    float height = 3.0f;
+    float lowHeight = 2.0f;     // while sliding
+    float lookAhead = 4.0f;
+    float lookHeight = 1.2f;
+
+    void reset(const glm::vec3& pos, const glm::vec3& target, float yawDegrees) {
+        position = pos;
+        lookAt = target;
+        yaw = yawDegrees;
+    }
+
+    void update(const glm::vec3& followPos, float followYaw, bool lowered, float dt) {
+        float yawDiff = followYaw - yaw;
+        if (yawDiff > 180.0f) yawDiff -= 360.0f;
+        if (yawDiff < -180.0f) yawDiff += 360.0f;
+        yaw += yawDiff * (1.0f - std::exp(-turnRate * dt));
+        if (yaw < 0.0f) yaw += 360.0f;
+        if (yaw >= 360.0f) yaw -= 360.0f;
+
+        float yawRad = glm::radians(yaw);
+        glm::vec3 forward(std::sin(yawRad), 0.0f, std::cos(yawRad));
+        glm::vec3 desiredPos = followPos - forward * distance + glm::vec3(0.0f, lowered ? lowHeight : height, 0.0f);
+        glm::vec3 desiredLook = followPos + forward * lookAhead + glm::vec3(0.0f, lookHeight, 0.0f);
+
+        float follow = 1.0f - std::exp(-followRate * dt);
+        position = glm::mix(position, desiredPos, follow);
+        lookAt = glm::mix(lookAt, desiredLook, follow);
+    }
+
+    CameraSnapshot snapshot(const CameraLens& lens, const glm::mat4& projection) const {
+        CameraSnapshot s;
+        s.position = position;
+        s.target = lookAt;
+        s.lens = lens;
+        s.tanHalfFov = std::tan(lens.fovY * 0.5f);
+        s.view = glm::lookAt(position, lookAt, glm::vec3(0.0f, 1.0f, 0.0f));
+        s.projection = projection;
+        s.viewProj = projection * s.view;
+        ExtractFrustumPlanes(s.viewProj, s.frustumPlanes);
+        return s;
+    }
+
+    glm::vec3 getPosition() const { return position; }
+
+private:
+    glm::vec3 position{ 0.0f, 3.0f, 6.5f };
+    glm::vec3 lookAt{ 0.0f, 1.2f, -4.0f };
+    float yaw = 180.0f;
+};
+
+#endif
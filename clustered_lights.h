@@ -0,0 +1,193 @@
+#ifndef CLUSTERED_LIGHTS_H
+#define CLUSTERED_LIGHTS_H
+
+#include <glm/glm.hpp>
+
+#include "job_system.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+struct PointLight {
+    glm::vec3 pos;
+    float radius;
+    glm::vec3 color;   // already multiplied by intensity
+};
+
+// Clustered forward lighting: the view frustum is split into TILES_X x TILES_Y screen tiles
+// and SLICES exponential depth slices. Every frame each light is binned into the froxels its
+// sphere touches, and the fragment shader only loops over the lights of its own froxel, so
+// shading cost follows the local light count instead of the total. Binning is split by depth
+// slice as jobs on the shared job system; each slice owns its froxels, so no locking is needed.
+//
+// Output layout (consumed through buffer textures):
+//   grid:    2 uints per cluster (first index, count), cluster = (slice * TILES_Y + y) * TILES_X + x
+//   indices: light indices, contiguous per cluster
+class LightClusters {
+public:
+    static const int TILES_X = 16;
+    static const int TILES_Y = 9;
+    static const int SLICES = 24;
+    static const int CLUSTER_COUNT = TILES_X * TILES_Y * SLICES;
+
+    float zNear = 0.5f;     // slice 0 starts here; closer fragments use slice 0
+    float zFar = 150.0f;    // no point lights are shaded beyond this
+    size_t maxIndices = 1 << 15;
+
+    void init(JobSystem& jobSystem) {
+        jobs = &jobSystem;
+        slices.resize(SLICES);
+        std::cout << "[Lights] " << TILES_X << "x" << TILES_Y << "x" << SLICES
+            << " clusters, binning on " << jobs->size() << " threads" << std::endl;
+    }
+
+    // Bins lights for a camera looking down -z in view space. Results stay valid until the next build.
+    void build(const std::vector<PointLight>& lights, const glm::mat4& view, float fovY, float aspect) {
+        tanY = std::tan(fovY * 0.5f);
+        tanX = tanY * aspect;
+        logScale = (float)SLICES / std::log(zFar / zNear);
+
+        // view-space spheres and their slice spans, computed once and shared by every slice job
+        viewLights.clear();
+        for (uint32_t i = 0; i < (uint32_t)lights.size(); ++i) {
+            const PointLight& l = lights[i];
+            glm::vec3 p = glm::vec3(view * glm::vec4(l.pos, 1.0f));
+            float depth = -p.z;
+            if (depth + l.radius < 0.0f || depth - l.radius > zFar) continue;   // behind the camera or too far
+            ViewLight v;
+            v.center = p;
+            v.radius = l.radius;
+            v.index = i;
+            v.firstSlice = sliceOf(depth - l.radius);
+            v.lastSlice = sliceOf(depth + l.radius);
+            viewLights.push_back(v);
+        }
+
+        jobs->parallelFor(SLICES, [this](int z) { binSlice(z); });
+
+        // stitch the per-slice lists into one grid + index list
+        grid.resize(CLUSTER_COUNT * 2);
+        indices.clear();
+        truncated = false;
+        for (int z = 0; z < SLICES; ++z) {
+            const Slice& s = slices[z];
+            for (int c = 0; c < TILES_X * TILES_Y; ++c) {
+                uint32_t offset = s.offsets[c], count = s.counts[c];
+                if (indices.size() + count > maxIndices) {
+                    count = 0;
+                    truncated = true;
+                }
+                size_t cluster = (size_t)z * TILES_X * TILES_Y + c;
+                grid[cluster * 2] = (uint32_t)indices.size();
+                grid[cluster * 2 + 1] = count;
+                indices.insert(indices.end(), s.indices.begin() + offset, s.indices.begin() + offset + count);
+            }
+        }
+        if (truncated && !warned) {
+            std::cerr << "[Lights] cluster index list full, dropping lights\n";
+            warned = true;
+        }
+    }
+
+    const std::vector<uint32_t>& gridData() const { return grid; }
+    const std::vector<uint32_t>& indexData() const { return indices; }
+    size_t visibleLights() const { return viewLights.size(); }
+    float sliceScale() const { return logScale; }
+
+private:
+    struct ViewLight {
+        glm::vec3 center;
+        float radius;
+        uint32_t index;
+        int firstSlice, lastSlice;
+    };
+
+    struct Slice {
+        uint32_t counts[TILES_X * TILES_Y];
+        uint32_t offsets[TILES_X * TILES_Y];
+        std::vector<uint32_t> indices;
+        std::vector<glm::ivec4> rects;   // tile rect of each light touching the slice
+        std::vector<uint32_t> rectLights;
+    };
+
+    int sliceOf(float depth) const {
+        if (depth <= zNear) return 0;
+        int s = (int)(std::log(depth / zNear) * logScale);
+        return s < 0 ? 0 : (s >= SLICES ? SLICES - 1 : s);
+    }
+
+    float sliceDepth(int s) const { return zNear * std::exp((float)s / logScale); }
+
+    // Screen-space tile range of a light inside one slice. The sphere's x/y extent is projected
+    // at both ends of its depth span within the slice, which bounds the projection conservatively.
+    bool tileRect(const ViewLight& l, float z0, float z1, glm::ivec4& rect) const {
+        float depth = -l.center.z;
+        float za = std::max(std::max(z0, depth - l.radius), 1e-3f);
+        float zb = std::min(z1, depth + l.radius);
+        if (za > zb) return false;
+
+        float x0 = l.center.x - l.radius, x1 = l.center.x + l.radius;
+        float y0 = l.center.y - l.radius, y1 = l.center.y + l.radius;
+        float minX = std::min(x0 / (za * tanX), x0 / (zb * tanX));
+        float maxX = std::max(x1 / (za * tanX), x1 / (zb * tanX));
+        float minY = std::min(y0 / (za * tanY), y0 / (zb * tanY));
+        float maxY = std::max(y1 / (za * tanY), y1 / (zb * tanY));
+        if (maxX < -1.0f || minX > 1.0f || maxY < -1.0f || minY > 1.0f) return false;
+
+        rect.x = std::max(0, (int)std::floor((minX * 0.5f + 0.5f) * TILES_X));
+        rect.y = std::max(0, (int)std::floor((minY * 0.5f + 0.5f) * TILES_Y));
+        rect.z = std::min(TILES_X - 1, (int)std::floor((maxX * 0.5f + 0.5f) * TILES_X));
+        rect.w = std::min(TILES_Y - 1, (int)std::floor((maxY * 0.5f + 0.5f) * TILES_Y));
+        return true;
+    }
+
+    // Counting pass, prefix sum, then fill: every cluster list of the slice is contiguous.
+    void binSlice(int z) {
+        Slice& s = slices[z];
+        std::fill(s.counts, s.counts + TILES_X * TILES_Y, 0u);
+        s.rects.clear();
+        s.rectLights.clear();
+
+        float z0 = z == 0 ? 0.0f : sliceDepth(z);
+        float z1 = sliceDepth(z + 1);
+        for (const ViewLight& l : viewLights) {
+            if (z < l.firstSlice || z > l.lastSlice) continue;
+            glm::ivec4 rect;
+            if (!tileRect(l, z0, z1, rect)) continue;
+            s.rects.push_back(rect);
+            s.rectLights.push_back(l.index);
+            for (int y = rect.y; y <= rect.w; ++y)
+                for (int x = rect.x; x <= rect.z; ++x)
+                    s.counts[y * TILES_X + x]++;
+        }
+
+        uint32_t total = 0;
+        for (int c = 0; c < TILES_X * TILES_Y; ++c) {
+            s.offsets[c] = total;
+            total += s.counts[c];
+        }
+        s.indices.resize(total);
+
+        uint32_t cursor[TILES_X * TILES_Y];
+        std::copy(s.offsets, s.offsets + TILES_X * TILES_Y, cursor);
+        for (size_t i = 0; i < s.rects.size(); ++i) {
+            const glm::ivec4& rect = s.rects[i];
+            for (int y = rect.y; y <= rect.w; ++y)
+                for (int x = rect.x; x <= rect.z; ++x)
+                    s.indices[cursor[y * TILES_X + x]++] = s.rectLights[i];
+        }
+    }
+
+    JobSystem* jobs = nullptr;
+    std::vector<Slice> slices;
+    std::vector<ViewLight> viewLights;
+    std::vector<uint32_t> grid;
+    std::vector<uint32_t> indices;
+    float tanX = 1.0f, tanY = 1.0f, logScale = 1.0f;
+    bool truncated = false, warned = false;
+};
+
+#endif
@@ -0,0 +1,17 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 Corner;
+
+uniform vec3 objectColor;
+
+void main()
+{
+    float r2 = dot(Corner, Corner);
+    if (r2 > 1.0)
+        discard;
+    // fake a lit, slightly domed disc so far coins keep their sparkle
+    float shade = 0.65 + 0.35 * sqrt(1.0 - r2);
+    float rim = smoothstep(0.75, 0.95, r2) * 0.25;
+    FragColor = vec4(objectColor * (shade - rim), 1.0);
+}
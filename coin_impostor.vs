@@ -0,0 +1,22 @@
+#version 330 core
+
+// one camera-facing quad per far coin: xyz = center, w = radius
+layout(location = 0) in vec4 instanceSphere;
+
+layout(std140) uniform FrameData {
+    mat4 projection;
+    mat4 view;
+    vec4 viewPos;
+    vec4 lightPos;
+};
+
+out vec2 Corner;
+
+void main()
+{
+    Corner = vec2((gl_VertexID & 1) == 0 ? -1.0 : 1.0, (gl_VertexID & 2) == 0 ? -1.0 : 1.0);
+    vec3 camRight = vec3(view[0][0], view[1][0], view[2][0]);
+    vec3 camUp = vec3(view[0][1], view[1][1], view[2][1]);
+    vec3 worldPos = instanceSphere.xyz + (camRight * Corner.x + camUp * Corner.y) * instanceSphere.w;
+    gl_Position = projection * view * vec4(worldPos, 1.0);
+}
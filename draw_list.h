@@ -0,0 +1,158 @@
+#ifndef DRAW_LIST_H
+#define DRAW_LIST_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "camera_rig.h"
+#include "game_world.h"
+#include "occlusion_buffer.h"
+#include "render_queue.h"
+
+#include <cstdint>
+#include <vector>
+
+// The GL-free half of the per-draw level and coin path: which floors, walls, obstacles and
+// coins are drawn, with what transform and LOD, and the queue items they turn into. GL names
+// come in as plain numbers and each item's ObjectData range from a callback, so the game's
+// frame jobs and tools/microbench.cpp run the same code.
+
+enum LevelMesh { LEVEL_MESH_FLOOR = 0, LEVEL_MESH_BOX = 1 };
+
+// Geometry of one mesh (or LOD) as the render queue sees it
+struct MeshDraw {
+    unsigned int texture = 0;
+    unsigned int vao = 0;
+    int indexCount = 0;
+};
+
+// Only the first blocksAhead live blocks in front of the player are drawn.
+inline bool inDrawRange(const World& world, const Block& block, int blocksAhead) {
+    return world.playerBlock < 0 || block.blockIndex <= world.playerBlock + blocksAhead;
+}
+
+const int MAX_LEVEL_PIECES = 5;   // per block: floor, two side walls, front wall, obstacle
+
+// Every floor, wall and obstacle of a block as (mesh, center, size), in the order both level
+// paths draw them.
+template <typename F>
+inline void forEachLevelPiece(const Block& block, F&& fn) {
+    fn(LEVEL_MESH_FLOOR, block.centerPos, glm::vec3(Block::SIZE, 1.0f, Block::SIZE));
+    if (block.leftWall.size.x > 0.1f) fn(LEVEL_MESH_BOX, block.leftWall.pos, block.leftWall.size);
+    if (block.rightWall.size.x > 0.1f) fn(LEVEL_MESH_BOX, block.rightWall.pos, block.rightWall.size);
+    if (block.hasFrontWall) fn(LEVEL_MESH_BOX, block.frontWall.pos, block.frontWall.size);
+    if (block.hasObstacle) fn(LEVEL_MESH_BOX, block.obstacle.pos, block.obstacle.size);
+}
+
+struct LevelPiece {
+    MeshDraw mesh;
+    glm::mat4 model;
+    glm::vec3 pos;
+    bool visible;   // in the camera frustum and not occluded; hidden pieces still cast shadows
+};
+
+// Transforms and camera culling of every level piece in draw range. unoccluded holds the
+// occlusion result per piece in forEachLevelPiece order; pieces past its end count as visible.
+inline void cullLevelPieces(const World& world, int blocksAhead, const CameraSnapshot& cam, const MeshDraw meshes[2],
+    const std::vector<uint8_t>& unoccluded, std::vector<LevelPiece>& out) {
+    out.clear();
+    size_t index = 0;
+    for (const auto& block : world.blocks) {
+        if (!inDrawRange(world, block, blocksAhead)) continue;
+        forEachLevelPiece(block, [&](LevelMesh mesh, const glm::vec3& pos, const glm::vec3& size) {
+            LevelPiece piece;
+            piece.mesh = meshes[mesh];
+            piece.model = glm::scale(glm::translate(glm::mat4(1.0f), pos), size);
+            piece.pos = pos;
+            piece.visible = (index >= unoccluded.size() || unoccluded[index]) &&
+                AabbInFrustum(cam.frustumPlanes, pos - size * 0.5f, pos + size * 0.5f);
+            out.push_back(piece);
+            index++;
+        });
+    }
+}
+
+struct CoinDraw {
+    glm::mat4 model;
+    glm::vec3 center;
+    int lod;
+};
+
+// Drops the coins outside the camera frustum or behind the walls (occlusion may be null) and
+// picks a LOD for the rest; impostor-range coins go to impostors as (center, radius).
+// Returns the number of occluded coins.
+inline int cullCoinDraws(const World& world, int blocksAhead, const CameraSnapshot& cam, float viewportHeight,
+    const ScreenSizeLod& lods, const OcclusionBuffer* occlusion, std::vector<CoinDraw>& draws, std::vector<glm::vec4>& impostors) {
+    draws.clear();
+    impostors.clear();
+    int occluded = 0;
+
+    // flat disc: half the bounding diagonal over sqrt(2) is roughly the face radius
+    const float impostorRadius = lods.radius * 0.7071f;
+
+    for (const auto& block : world.blocks) {
+        if (!inDrawRange(world, block, blocksAhead)) continue;
+        for (const auto& coin : block.coins) {
+            if (coin.collected) continue;
+
+            glm::vec3 center = coin.pos + lods.center;
+            if (!SphereInFrustum(cam.frustumPlanes, center, lods.radius)) continue;
+            if (occlusion && !occlusion->visible(center - glm::vec3(lods.radius), center + glm::vec3(lods.radius))) {
+                occluded++;
+                continue;
+            }
+            int lod = lods.select(center, cam.position, cam.tanHalfFov, viewportHeight);
+            if (lod == ScreenSizeLod::IMPOSTOR) {
+                impostors.push_back(glm::vec4(center, impostorRadius));
+                continue;
+            }
+
+            glm::mat4 model = glm::translate(glm::mat4(1.0f), coin.pos);
+            model = glm::rotate(model, world.coinSpin, glm::vec3(0, 1, 0));
+            draws.push_back({ model, center, lod });
+        }
+    }
+    return occluded;
+}
+
+// A mesh item keyed front to back from eye. objectOffset < 0 means no ObjectData.
+inline void pushMeshItem(RenderQueue& queue, const glm::vec3& eye, RenderPass pass, unsigned int program,
+    const MeshDraw& mesh, long long objectOffset, long long objectSize, const glm::vec3& pos) {
+    RenderItem item;
+    item.pass = pass;
+    item.program = program;
+    item.texture = mesh.texture;
+    item.vao = mesh.vao;
+    item.indexCount = mesh.indexCount;
+    item.objectOffset = objectOffset;
+    item.objectSize = objectSize;
+    queue.push(item, glm::length(pos - eye));
+}
+
+// Queue items for the visible pieces. object(model) stores a piece's ObjectData and returns
+// its range (offset, size, valid()); caster(mesh, range) sees every piece, hidden ones too.
+template <typename ObjectFn, typename CasterFn>
+inline void queueLevelPieces(RenderQueue& queue, const glm::vec3& eye, unsigned int program,
+    const std::vector<LevelPiece>& pieces, ObjectFn&& object, CasterFn&& caster) {
+    for (const auto& piece : pieces) {
+        auto range = object(piece.model);
+        if (!range.valid()) continue;
+        if (piece.visible)
+            pushMeshItem(queue, eye, RenderPass::Opaque, program, piece.mesh, range.offset, range.size, piece.pos);
+        caster(piece.mesh, range);
+    }
+}
+
+// Queue items for the coin draws, with the mesh of each LOD in lodMeshes.
+template <typename ObjectFn, typename CasterFn>
+inline void queueCoinDraws(RenderQueue& queue, const glm::vec3& eye, unsigned int program, const MeshDraw lodMeshes[],
+    const std::vector<CoinDraw>& draws, ObjectFn&& object, CasterFn&& caster) {
+    for (const auto& coin : draws) {
+        auto range = object(coin.model);
+        if (!range.valid()) continue;
+        pushMeshItem(queue, eye, RenderPass::Opaque, program, lodMeshes[coin.lod], range.offset, range.size, coin.center);
+        caster(lodMeshes[coin.lod], range);
+    }
+}
+
+#endif
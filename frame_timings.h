@@ -0,0 +1,42 @@
+#ifndef FRAME_TIMINGS_H
+#define FRAME_TIMINGS_H
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+// Collects per-frame times in milliseconds and summarizes them for benchmark runs.
+class FrameTimings {
+public:
+    void add(double ms) { samples.push_back(ms); }
+    void clear() { samples.clear(); }
+    void reserve(size_t frames) { samples.reserve(frames); }
+    size_t count() const { return samples.size(); }
+
+    double mean() const {
+        if (samples.empty()) return 0.0;
+        double sum = 0.0;
+        for (double s : samples) sum += s;
+        return sum / (double)samples.size();
+    }
+
+    // Nearest-rank percentile, p in [0, 100]
+    double percentile(double p) const {
+        if (samples.empty()) return 0.0;
+        std::vector<double> sorted(samples);
+        std::sort(sorted.begin(), sorted.end());
+        size_t rank = (size_t)(p / 100.0 * (double)(sorted.size() - 1) + 0.5);
+        return sorted[std::min(rank, sorted.size() - 1)];
+    }
+
+    void report(const char* label) const {
+        std::printf("[Bench] %s: %zu frames, mean %.3f ms (%.1f fps), p50 %.3f, p95 %.3f, p99 %.3f, max %.3f ms\n",
+            label, count(), mean(), mean() > 0.0 ? 1000.0 / mean() : 0.0,
+            percentile(50.0), percentile(95.0), percentile(99.0), percentile(100.0));
+    }
+
+private:
+    std::vector<double> samples;
+};
+
+#endif
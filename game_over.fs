@@ -0,0 +1,21 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D snapshot;
+uniform float fade;   // 0 = last frame as it was, 1 = full game-over look
+
+void main()
+{
+    vec3 color = texture(snapshot, TexCoords).rgb;
+
+    // desaturate toward a dark red tint and close in with a vignette
+    float luma = dot(color, vec3(0.299, 0.587, 0.114));
+    vec3 tinted = vec3(luma * 0.9, luma * 0.25, luma * 0.2);
+    vec2 d = TexCoords - 0.5;
+    float vignette = 1.0 - smoothstep(0.25, 0.75, length(d));
+
+    vec3 result = mix(color, tinted * mix(1.0, vignette, 0.8), fade);
+    FragColor = vec4(result, 1.0);
+}
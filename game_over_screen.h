@@ -0,0 +1,66 @@
+#ifndef GAME_OVER_SCREEN_H
+#define GAME_OVER_SCREEN_H
+
+#include <glad/glad.h>
+
+#include "render_target.h"
+
+// Game-over screen: the last frame of the run is copied into a texture once and shown with a
+// cheap fullscreen post-effect, instead of re-rendering the frozen scene every frame.
+class GameOverScreen {
+public:
+    void init() {
+        glGenTextures(1, &texture);
+        glGenFramebuffers(1, &fbo);
+        // the triangle is generated from gl_VertexID, but core profile still needs a VAO bound
+        glGenVertexArrays(1, &VAO);
+    }
+
+    // Copies the color of the finished frame in source before it is swapped away.
+    void capture(const RenderTarget& source) {
+        int w = source.getWidth(), h = source.getHeight();
+        if (w != width || h != height) {
+            width = w;
+            height = h;
+            glBindTexture(GL_TEXTURE_2D, texture);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glBindTexture(GL_TEXTURE_2D, 0);
+            glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+        }
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, source.framebuffer());
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbo);
+        glBlitFramebuffer(0, 0, w, h, 0, 0, w, h, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+        source.bind();
+        captured = true;
+    }
+
+    void release() { captured = false; }
+    bool hasCapture() const { return captured; }
+
+    // Draws the snapshot over the whole target; fade goes 0 -> 1 as the effect settles in.
+    void present(unsigned int program, const RenderTarget& target, float fade) const {
+        target.bind();
+        glDisable(GL_DEPTH_TEST);
+        glUseProgram(program);
+        glUniform1i(glGetUniformLocation(program, "snapshot"), 0);
+        glUniform1f(glGetUniformLocation(program, "fade"), fade);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glBindVertexArray(VAO);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        glBindVertexArray(0);
+        glEnable(GL_DEPTH_TEST);
+    }
+
+private:
+    GLuint texture = 0, fbo = 0, VAO = 0;
+    int width = 0, height = 0;
+    bool captured = false;
+};
+
+#endif
@@ -0,0 +1,799 @@
+#ifndef GAME_WORLD_H
+#define GAME_WORLD_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "input_record.h"
+#include "level_stream.h"
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// ------------- player ---------------
+enum class AnimState { Running, Jumping, Sliding };
+
+struct Player {
+    float scale = 1.0f;
+
+    glm::vec3 pos{ 0.0f, 0.0f, 0.0f };
+    glm::vec3 vel{ 0.0f, 0.0f, 0.0f };
+    float yaw = 180.0f;
+    float targetYaw = 180.0f;
+    float forwardVel = 6.0f;
+    float lateralSpeed = 50.0f;
+    float jumpSpeed = 5.0f;
+    float gravity = 12.0f;
+    bool  onGround = true;
+    AnimState state = AnimState::Running;
+
+    float standHalfWidth = 0.35f;
+    float standHalfDepth = 0.25f;
+    float standHeight = 1.8f;
+    float slideHeight = 1.0f;
+
+    bool  sliding = false;
+    float slideTimer = 0.0f;
+    float slideDuration = 1.5f;
+
+    float maxLateral = 4.0f;
+
+    glm::vec3 slideRootStart{ 0.0f, 0.0f, 0.0f };
+    glm::vec3 slideRootCurrent{ 0.0f, 0.0f, 0.0f };
+    bool slideRootInitialized = false;
+
+    float halfW()   const { return standHalfWidth * scale; }
+    float halfD()   const { return standHalfDepth * scale; }
+    float standH()  const { return standHeight * scale; }
+    float slideH()  const { return slideHeight * scale; }
+
+    glm::vec3 getForwardDir() const {
+        float yawRad = glm::radians(yaw);
+        return glm::vec3(sin(yawRad), 0.0f, cos(yawRad));
+    }
+
+    glm::vec3 getRightDir() const {
+        glm::vec3 forward = getForwardDir();
+        return glm::cross(forward, glm::vec3(0.0f, 1.0f, 0.0f));
+    }
+
+    void turnLeft() {
+        if (!sliding && onGround) {
+            yaw += 90.0f;
+            if (yaw >= 360.0f) yaw -= 360.0f;
+        }
+    }
+
+    void turnRight() {
+        if (!sliding && onGround) {
+            yaw -= 90.0f;
+            if (yaw < 0.0f) yaw += 360.0f;
+        }
+    }
+
+    glm::vec3 getSlideOffset() const {
+        if (!slideRootInitialized) return glm::vec3(0.0f);
+
+        glm::vec3 delta = slideRootCurrent - slideRootStart;
+
+        float yawRad = glm::radians(yaw);
+        float c = cos(yawRad);
+        float s = sin(yawRad);
+
+        glm::vec3 worldDelta;
+        worldDelta.x = delta.x * c - delta.z * s;
+        worldDelta.y = 0.0f;
+        worldDelta.z = delta.x * s + delta.z * c;
+
+        return worldDelta;
+    }
+
+    std::vector<glm::mat4> removeRootMotion(std::vector<glm::mat4> bones) const {
+        if (!sliding || !slideRootInitialized || bones.empty()) return bones;
+
+        glm::vec3 delta = slideRootCurrent - slideRootStart;
+        delta.y = 0.0f;
+
+        glm::mat4 cancelMat = glm::translate(glm::mat4(1.0f), -delta);
+
+        for (size_t i = 0; i < bones.size(); ++i) {
+            bones[i] = cancelMat * bones[i];
+        }
+
+        return bones;
+    }
+
+    void startSlide() {
+        if (onGround && !sliding) {
+            sliding = true;
+            slideTimer = slideDuration;
+            state = AnimState::Sliding;
+            slideRootInitialized = false;
+        }
+    }
+
+    void updatePhysics(float dt, float mouseDeltaX) {
+        glm::vec3 forward = getForwardDir();
+        pos += forward * forwardVel * dt;
+
+        const float MOUSE_SENS = 0.02f;
+        float lateralMove = mouseDeltaX * MOUSE_SENS * lateralSpeed;
+        glm::vec3 right = getRightDir();
+        pos += right * lateralMove * dt;
+
+        if (!sliding) {
+            if (!onGround) vel.y -= gravity * dt;
+            pos.y += vel.y * dt;
+            if (pos.y <= 0.0f) {
+                pos.y = 0.0f; vel.y = 0.0f;
+                if (!onGround) { onGround = true; state = AnimState::Running; }
+            }
+        }
+        else {
+            pos.y = 0.0f; vel.y = 0.0f;
+        }
+
+        if (sliding) {
+            slideTimer -= dt;
+            if (slideTimer <= 0.0f) {
+                sliding = false;
+                state = AnimState::Running;
+                slideRootInitialized = false;
+            }
+        }
+    }
+
+    void jump() {
+        if (onGround && !sliding) {
+            onGround = false;
+            vel.y = jumpSpeed;
+            state = AnimState::Jumping;
+        }
+    }
+
+    void getAABB(glm::vec3& minOut, glm::vec3& maxOut) const {
+        float h = sliding ? slideH() : standH();
+        glm::vec3 actualPos = pos;
+        if (sliding && slideRootInitialized) {
+            glm::vec3 slideOffset = getSlideOffset();
+            actualPos += slideOffset;
+        }
+        minOut = glm::vec3(actualPos.x - halfW(), 0.0f, actualPos.z - halfD());
+        maxOut = glm::vec3(actualPos.x + halfW(), actualPos.y + h, actualPos.z + halfD());
+    }
+
+    void updateSlideRootMotion(const std::vector<glm::mat4>& boneMatrices) {
+        if (!sliding || boneMatrices.empty()) return;
+
+        glm::vec3 currentRoot = glm::vec3(boneMatrices[0][3]);
+
+        if (!slideRootInitialized) {
+            slideRootStart = currentRoot;
+            slideRootInitialized = true;
+        }
+
+        slideRootCurrent = currentRoot;
+    }
+
+};
+
+// ------------- collision util ------------------
+inline bool AABBIntersect(const glm::vec3& amin, const glm::vec3& amax,
+    const glm::vec3& bmin, const glm::vec3& bmax) {
+    return (amin.x <= bmax.x && amax.x >= bmin.x) &&
+        (amin.y <= bmax.y && amax.y >= bmin.y) &&
+        (amin.z <= bmax.z && amax.z >= bmin.z);
+}
+
+// ------------- Block-based generation ------------------
+enum class BlockType {
+    Normal,
+    TurnLeft,
+    TurnRight,
+    TurnStraight
+};
+
+enum class ObsType { None, JumpWall, SlideGate };
+
+struct Wall {
+    glm::vec3 pos, size;
+};
+
+struct Obstacle {
+    ObsType type = ObsType::None;
+    glm::vec3 pos, size;
+    bool hit = false;
+
+    void getAABB(glm::vec3& mn, glm::vec3& mx) const {
+        mn = pos - size * 0.5f;
+        mx = pos + size * 0.5f;
+    }
+};
+
+struct Block {
+    int blockIndex;
+    BlockType type;
+    glm::vec3 centerPos;
+    float yaw;
+
+    Wall leftWall;
+    Wall rightWall;
+    Wall frontWall;
+    bool hasFrontWall = false;
+
+    Obstacle obstacle;
+    bool hasObstacle = false;
+
+    // Coins
+    struct Coin {
+        glm::vec3 pos;
+        bool collected = false;
+    };
+    static constexpr int MAX_COINS = 5;
+
+    // Coins are stored inline, so a block never touches the heap and copies as plain data
+    struct CoinList {
+        Coin items[MAX_COINS];
+        int count = 0;
+
+        void push_back(const Coin& coin) { if (count < MAX_COINS) items[count++] = coin; }
+        void clear() { count = 0; }
+        size_t size() const { return (size_t)count; }
+        size_t capacity() const { return MAX_COINS; }
+        bool empty() const { return count == 0; }
+        Coin* begin() { return items; }
+        Coin* end() { return items + count; }
+        const Coin* begin() const { return items; }
+        const Coin* end() const { return items + count; }
+    };
+    CoinList coins;
+
+    // Block size
+    static constexpr float SIZE = 5.0f;  // 5x5 units
+    static constexpr float WALL_HEIGHT = 2.0f;
+    static constexpr float WALL_THICKNESS = 0.5f;
+};
+
+inline glm::vec3 getDirectionFromYaw(float yaw) {
+    float yawRad = glm::radians(yaw);
+    return glm::vec3(sin(yawRad), 0.0f, cos(yawRad));
+}
+
+// Helper to get perpendicular right direction
+inline glm::vec3 getRightFromYaw(float yaw) {
+    glm::vec3 forward = getDirectionFromYaw(yaw);
+    return glm::cross(forward, glm::vec3(0.0f, 1.0f, 0.0f));
+}
+
+// ------------- block templates ------------------
+// Block yaws are always multiples of 90 degrees, so every wall, obstacle and coin offset is
+// worked out at compile time for the 4 orientations (0, 90, 180, 270 degrees) and 4 block
+// types. Creating a block is a table lookup plus a translation to its center.
+struct ShapeVec {   // constexpr stand-in for glm::vec3
+    float x, y, z;
+};
+
+inline glm::vec3 toVec3(const ShapeVec& v) { return glm::vec3(v.x, v.y, v.z); }
+
+// getDirectionFromYaw / getRightFromYaw for each orientation, without rounding noise
+constexpr ShapeVec ORIENT_FORWARD[4] = { { 0.0f, 0.0f, 1.0f }, { 1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, -1.0f }, { -1.0f, 0.0f, 0.0f } };
+constexpr ShapeVec ORIENT_RIGHT[4] = { { -1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 1.0f }, { 1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, -1.0f } };
+
+inline int yawOrientation(float yaw) {
+    int q = (int)std::lround(yaw / 90.0f) % 4;
+    return q < 0 ? q + 4 : q;
+}
+
+constexpr ShapeVec shapeZero() { return ShapeVec{ 0.0f, 0.0f, 0.0f }; }
+
+// dir * along + up * height
+constexpr ShapeVec shapeOffset(ShapeVec dir, float along, float height) {
+    return ShapeVec{ dir.x * along, height, dir.z * along };
+}
+
+constexpr ShapeVec shapeAdd(ShapeVec a, ShapeVec b) { return ShapeVec{ a.x + b.x, a.y + b.y, a.z + b.z }; }
+
+// A size given for a block facing +-Z, turned for +-X
+constexpr ShapeVec orientedSize(int orientation, float x, float y, float z) {
+    return (orientation & 1) ? ShapeVec{ z, y, x } : ShapeVec{ x, y, z };
+}
+
+struct BlockShape {
+    ShapeVec leftWallPos, leftWallSize;
+    ShapeVec rightWallPos, rightWallSize;
+    ShapeVec frontWallPos, frontWallSize;
+    bool hasFrontWall;
+};
+
+// Wall layout of one orientation and type, relative to the block center. A turn block has a
+// front wall and no wall on the side it turns to; a missing wall has zero size.
+template <int Orientation, BlockType Type>
+constexpr BlockShape blockShape() {
+    return BlockShape{
+        Type == BlockType::TurnLeft ? shapeZero()
+            : shapeOffset(ORIENT_RIGHT[Orientation], -(Block::SIZE * 0.5f + Block::WALL_THICKNESS * 0.5f), Block::WALL_HEIGHT * 0.5f),
+        Type == BlockType::TurnLeft ? shapeZero()
+            : orientedSize(Orientation, Block::WALL_THICKNESS, Block::WALL_HEIGHT, Block::SIZE),
+        Type == BlockType::TurnRight ? shapeZero()
+            : shapeOffset(ORIENT_RIGHT[Orientation], Block::SIZE * 0.5f + Block::WALL_THICKNESS * 0.5f, Block::WALL_HEIGHT * 0.5f),
+        Type == BlockType::TurnRight ? shapeZero()
+            : orientedSize(Orientation, Block::WALL_THICKNESS, Block::WALL_HEIGHT, Block::SIZE),
+        Type == BlockType::TurnLeft || Type == BlockType::TurnRight
+            ? shapeOffset(ORIENT_FORWARD[Orientation], Block::SIZE * 0.5f + Block::WALL_THICKNESS * 0.5f, Block::WALL_HEIGHT * 0.5f)
+            : shapeZero(),
+        Type == BlockType::TurnLeft || Type == BlockType::TurnRight
+            ? orientedSize(Orientation, Block::SIZE + Block::WALL_THICKNESS * 2.0f, Block::WALL_HEIGHT, Block::WALL_THICKNESS)
+            : shapeZero(),
+        Type == BlockType::TurnLeft || Type == BlockType::TurnRight
+    };
+}
+
+#define BLOCK_SHAPES_FOR(o) { blockShape<o, BlockType::Normal>(), blockShape<o, BlockType::TurnLeft>(), \
+                              blockShape<o, BlockType::TurnRight>(), blockShape<o, BlockType::TurnStraight>() }
+constexpr BlockShape BLOCK_SHAPES[4][4] = { BLOCK_SHAPES_FOR(0), BLOCK_SHAPES_FOR(1), BLOCK_SHAPES_FOR(2), BLOCK_SHAPES_FOR(3) };
+#undef BLOCK_SHAPES_FOR
+
+// Obstacle size by [type - JumpWall][orientation & 1] and height of its center by type; it
+// sits on the block center
+constexpr ShapeVec OBSTACLE_SIZE[2][2] = {
+    { { Block::SIZE, 0.6f, 0.7f }, { 0.7f, 0.6f, Block::SIZE } },   // jump wall
+    { { Block::SIZE, 1.0f, 1.2f }, { 1.2f, 1.0f, Block::SIZE } },   // slide gate
+};
+constexpr float OBSTACLE_HEIGHT[2] = { 0.3f, 1.5f };
+
+// Coin rows: MAX_COINS coins spaced 0.8 apart along the block, in the left (-1) or right (+1)
+// lane or crossing between them, at 1.0 high or arcing over a jump wall.
+enum CoinPattern { COIN_LEFT, COIN_RIGHT, COIN_LEFT_TO_RIGHT, COIN_RIGHT_TO_LEFT, COIN_PATTERN_COUNT };
+
+static_assert(Block::MAX_COINS == 5, "coin rows are laid out for five coins");
+
+constexpr float coinLateral(int pattern, int i) {
+    return pattern == COIN_LEFT ? -1.0f
+        : pattern == COIN_RIGHT ? 1.0f
+        : pattern == COIN_LEFT_TO_RIGHT ? -1.0f + 2.0f * ((i + 1) / 6.0f)
+        : 1.0f - 2.0f * ((i + 1) / 6.0f);
+}
+
+constexpr float coinHeight(bool arc, int i) {
+    return !arc ? 1.0f : i == 2 ? 1.8f : (i == 1 || i == 3) ? 1.4f : 1.0f;
+}
+
+constexpr ShapeVec coinOffset(int orientation, int pattern, bool arc, int i) {
+    return shapeAdd(shapeOffset(ORIENT_RIGHT[orientation], coinLateral(pattern, i), coinHeight(arc, i)),
+                    shapeOffset(ORIENT_FORWARD[orientation], (i - 2) * 0.8f, 0.0f));
+}
+
+struct CoinRow {
+    ShapeVec offsets[Block::MAX_COINS];
+};
+
+template <int Orientation, int Pattern, bool Arc>
+constexpr CoinRow coinRow() {
+    return CoinRow{ { coinOffset(Orientation, Pattern, Arc, 0), coinOffset(Orientation, Pattern, Arc, 1),
+                      coinOffset(Orientation, Pattern, Arc, 2), coinOffset(Orientation, Pattern, Arc, 3),
+                      coinOffset(Orientation, Pattern, Arc, 4) } };
+}
+
+#define COIN_ROWS_FOR(o) { { coinRow<o, COIN_LEFT, false>(), coinRow<o, COIN_LEFT, true>() }, \
+                           { coinRow<o, COIN_RIGHT, false>(), coinRow<o, COIN_RIGHT, true>() }, \
+                           { coinRow<o, COIN_LEFT_TO_RIGHT, false>(), coinRow<o, COIN_LEFT_TO_RIGHT, true>() }, \
+                           { coinRow<o, COIN_RIGHT_TO_LEFT, false>(), coinRow<o, COIN_RIGHT_TO_LEFT, true>() } }
+// [orientation][pattern][arc over a jump wall]
+constexpr CoinRow COIN_ROWS[4][COIN_PATTERN_COUNT][2] = { COIN_ROWS_FOR(0), COIN_ROWS_FOR(1), COIN_ROWS_FOR(2), COIN_ROWS_FOR(3) };
+#undef COIN_ROWS_FOR
+
+inline Block createBlock(int index, BlockType type, glm::vec3 center, float yaw) {
+    const BlockShape& shape = BLOCK_SHAPES[yawOrientation(yaw)][(int)type];
+    Block block;
+    block.blockIndex = index;
+    block.type = type;
+    block.centerPos = center;
+    block.yaw = yaw;
+    block.leftWall.pos = center + toVec3(shape.leftWallPos);
+    block.leftWall.size = toVec3(shape.leftWallSize);
+    block.rightWall.pos = center + toVec3(shape.rightWallPos);
+    block.rightWall.size = toVec3(shape.rightWallSize);
+    block.frontWall.pos = center + toVec3(shape.frontWallPos);
+    block.frontWall.size = toVec3(shape.frontWallSize);
+    block.hasFrontWall = shape.hasFrontWall;
+    return block;
+}
+
+// ------------- world ------------------
+// Something that happened during a step that the renderer may want to show. The simulation
+// never reads these back.
+enum class WorldEventType : uint8_t {
+    CoinPickup,
+    ObstacleHit,
+};
+
+struct WorldEvent {
+    WorldEventType type = WorldEventType::CoinPickup;
+    glm::vec3 pos{ 0.0f };
+};
+
+// The whole simulation of one run: player, live blocks, level generator and score. Nothing
+// here touches GL or the window, so the game owns one World and tools can step thousands of
+// them side by side. The streaming window comes from `streaming`; blockBytes lets the
+// renderer charge the GPU records it keeps per block against the budget.
+class World {
+public:
+    Player player;
+    WindowRing<Block> blocks;
+    StreamingBudget streaming;
+    size_t (*blockBytes)(const Block& block) = nullptr;
+
+    int hp = 1;
+    int coinCount = 0;
+    bool gameOver = false;
+
+    float speed = 1.0f;
+    float speedIncreaseRate = 0.02f;  // How fast speed increases
+    float maxSpeed = 3.0f;
+    float time = 0.0f;
+    float coinSpin = 0.0f;   // yaw of every coin, turning with the game speed
+
+    // bumped whenever blocks are added or removed; the renderer also bumps it when the part
+    // of the window it draws moves
+    unsigned int revision = 0;
+    int playerBlock = -1;   // block the player stands in, -1 until found
+
+    // Events since the owner last called clearEvents(). The list is fixed-size so worlds
+    // nobody drains (batched training) never grow; events past MAX_EVENTS are dropped.
+    static const int MAX_EVENTS = 32;
+    WorldEvent events[MAX_EVENTS];
+    int eventCount = 0;
+
+    void clearEvents() { eventCount = 0; }
+
+    // Starts a fresh run whose level is generated from seed.
+    void reset(unsigned int seed) {
+        // room for the whole window: behind + the player's block + ahead, plus one being added
+        blocks.reserve(streaming.blocksAhead(Block::SIZE) + streaming.blocksBehind(Block::SIZE) + 2);
+        resetRun();
+        blocks.clear();
+        streaming.clear();
+        randState = seed;
+        nextBlockIndex = 0;
+        nextBlockCenter = glm::vec3(0.0f, 0.0f, 0.0f);
+        buildYaw = 180.0f;
+        coinOnLeftSide = true;
+        coinPatternStart = -1;
+        coinSwitchAtBlock4 = false;
+
+        // Fill the window in front of the start position; the player starts in block 0
+        int ahead = streaming.blocksAhead(Block::SIZE);
+        while (nextBlockIndex < ahead && streaming.canGrow(nextBlockIndex)) {
+            generateNextBlock();
+        }
+    }
+
+    // Level generation is deterministic from the seed, so a run can restart from a copy of
+    // another world's start instead of regenerating it. Blocks are copied into this world's
+    // existing slots; nothing is allocated.
+    void restartFrom(const World& start) {
+        blocks.reserve(start.blocks.capacity());
+        resetRun();
+        blocks.clear();
+        streaming.clear();
+        for (const Block& block : start.blocks) {
+            blocks.push_back(block);
+            streaming.add(bytesOf(block));
+        }
+        randState = start.randState;
+        nextBlockIndex = start.nextBlockIndex;
+        nextBlockCenter = start.nextBlockCenter;
+        buildYaw = start.buildYaw;
+        coinOnLeftSide = start.coinOnLeftSide;
+        coinPatternStart = start.coinPatternStart;
+        coinSwitchAtBlock4 = start.coinSwitchAtBlock4;
+    }
+
+    // One simulation tick. dt is unscaled; the speed multiplier is applied here. pressed holds
+    // the INPUT_* buttons that went down this tick, lateral is the sideways steering input.
+    void step(float dt, uint32_t pressed, float lateral) {
+        float scaledDt = dt * speed;
+
+        if (pressed & INPUT_JUMP) player.jump();
+        if (pressed & INPUT_SLIDE) player.startSlide();
+        if (pressed & INPUT_LEFT) player.turnLeft();
+        if (pressed & INPUT_RIGHT) player.turnRight();
+
+        player.updatePhysics(scaledDt, lateral);
+        coinSpin = std::fmod(coinSpin + 2.0f * scaledDt, 6.2831853f);
+
+        // Update block generation
+        updateBlockGeneration();
+
+        // Check collisions
+        checkBlockCollisions();
+        checkCoinCollisions();
+
+        // Increase game speed
+        time += dt;
+        speed = 1.0f + (time * speedIncreaseRate);
+        if (speed > maxSpeed) {
+            speed = maxSpeed;
+        }
+    }
+
+    // The live block with the given index, or nullptr.
+    const Block* findBlock(int blockIndex) const {
+        if (blocks.empty()) return nullptr;
+        int slot = blockIndex - blocks.front().blockIndex;
+        if (slot < 0 || slot >= (int)blocks.size()) return nullptr;
+        return &blocks[slot];
+    }
+
+private:
+    friend struct WorldBench;   // tools/microbench.cpp times the private steps on their own
+
+    unsigned int randState = 1234567u;
+    int nextBlockIndex = 0;
+    glm::vec3 nextBlockCenter{ 0.0f, 0.0f, 0.0f };
+    float buildYaw = 180.0f;
+
+    // Coin generation state
+    bool coinOnLeftSide = true;
+    int coinPatternStart = -1;
+    bool coinSwitchAtBlock4 = false;
+
+    void resetRun() {
+        player = Player();
+        hp = 1;
+        coinCount = 0;
+        gameOver = false;
+        speed = 1.0f;
+        time = 0.0f;
+        coinSpin = 0.0f;
+        revision++;
+        playerBlock = -1;
+        eventCount = 0;
+    }
+
+    void addEvent(WorldEventType type, const glm::vec3& pos) {
+        if (eventCount == MAX_EVENTS) return;
+        events[eventCount].type = type;
+        events[eventCount].pos = pos;
+        eventCount++;
+    }
+
+    size_t bytesOf(const Block& block) const { return blockBytes ? blockBytes(block) : sizeof(Block); }
+
+    float frand01() {
+        randState = 1664525u * randState + 1013904223u;
+        return (randState >> 8) * (1.0f / 16777216.0f);
+    }
+
+    void generateNextBlock() {
+        BlockType type = BlockType::Normal;
+        bool shouldHaveObstacle = false;
+
+        // Every 20th block (20, 40, 60...) is a turn block
+        if (nextBlockIndex > 0 && nextBlockIndex % 20 == 0) {
+            float r = frand01();
+            if (r < 0.33f) {
+                type = BlockType::TurnStraight;
+            }
+            else if (r < 0.66f) {
+                type = BlockType::TurnLeft;
+            }
+            else {
+                type = BlockType::TurnRight;
+            }
+        }
+        // Every block where index % 4 == 1, starting from block 5 (5, 9, 13, 17...) has an obstacle
+        // But exclude blocks where %20 == 1 (21, 41, 61...) which are right after turns
+        else if (nextBlockIndex >= 5 && nextBlockIndex % 4 == 1 && nextBlockIndex % 20 != 1) {
+            shouldHaveObstacle = true;
+        }
+
+        const int orientation = yawOrientation(buildYaw);
+        Block block = createBlock(nextBlockIndex, type, nextBlockCenter, buildYaw);
+
+        // Add obstacle if needed
+        if (shouldHaveObstacle) {
+            block.hasObstacle = true;
+            ObsType obsType = (frand01() < 0.5f) ? ObsType::JumpWall : ObsType::SlideGate;
+            int kind = obsType == ObsType::JumpWall ? 0 : 1;
+            block.obstacle.type = obsType;
+            block.obstacle.pos = block.centerPos;
+            block.obstacle.pos.y = OBSTACLE_HEIGHT[kind];
+            block.obstacle.size = toVec3(OBSTACLE_SIZE[kind][orientation & 1]);
+        }
+
+        // Generate coins for blocks where index % 10 == 2,3,4,5,6
+        int blockMod10 = nextBlockIndex % 10;
+        if (blockMod10 >= 2 && blockMod10 <= 6) {
+            // At block %10 == 2, start a new coin pattern
+            if (blockMod10 == 2) {
+                coinOnLeftSide = (frand01() < 0.5f);
+                coinSwitchAtBlock4 = false;
+            }
+
+            // At block %10 == 4, 50% chance to switch sides
+            if (blockMod10 == 4) {
+                coinSwitchAtBlock4 = (frand01() < 0.5f);
+            }
+
+            // The switch happens across block 4; from block 5 on the coins are on the other side
+            int pattern;
+            if (blockMod10 == 4 && coinSwitchAtBlock4) pattern = coinOnLeftSide ? COIN_LEFT_TO_RIGHT : COIN_RIGHT_TO_LEFT;
+            else if (coinSwitchAtBlock4 && blockMod10 >= 5) pattern = coinOnLeftSide ? COIN_RIGHT : COIN_LEFT;
+            else pattern = coinOnLeftSide ? COIN_LEFT : COIN_RIGHT;
+
+            // coins arc over a jump wall
+            bool arc = block.hasObstacle && block.obstacle.type == ObsType::JumpWall;
+            const CoinRow& row = COIN_ROWS[orientation][pattern][arc ? 1 : 0];
+            for (int i = 0; i < Block::MAX_COINS; i++) {
+                Block::Coin coin;
+                coin.pos = block.centerPos + toVec3(row.offsets[i]);
+                block.coins.push_back(coin);
+            }
+        }
+
+        blocks.push_back(block);
+        revision++;
+        streaming.add(bytesOf(blocks.back()));
+
+        // Calculate next block position
+        nextBlockCenter += toVec3(ORIENT_FORWARD[orientation]) * Block::SIZE;
+
+        // Update build direction if this was a turn block
+        if (type == BlockType::TurnLeft) {
+            buildYaw += 90.0f;
+            if (buildYaw >= 360.0f) buildYaw -= 360.0f;
+            // Adjust next center for the turn
+            nextBlockCenter = block.centerPos + toVec3(ORIENT_RIGHT[orientation]) * (-Block::SIZE);
+        }
+        else if (type == BlockType::TurnRight) {
+            buildYaw -= 90.0f;
+            if (buildYaw < 0.0f) buildYaw += 360.0f;
+            // Adjust next center for the turn
+            nextBlockCenter = block.centerPos + toVec3(ORIENT_RIGHT[orientation]) * Block::SIZE;
+        }
+
+        nextBlockIndex++;
+    }
+
+    void updateBlockGeneration() {
+        // Find the block the player is currently in
+        int found = -1;
+        for (const auto& block : blocks) {
+            glm::vec3 toPlayer = player.pos - block.centerPos;
+            float distSq = toPlayer.x * toPlayer.x + toPlayer.z * toPlayer.z;
+            if (distSq < Block::SIZE * Block::SIZE) {
+                found = block.blockIndex;
+                break;
+            }
+        }
+        if (found < 0) return;
+        playerBlock = found;
+
+        // Remove blocks far behind first, so their memory counts toward the blocks ahead
+        int behind = streaming.blocksBehind(Block::SIZE);
+        while (!blocks.empty() && blocks.front().blockIndex < playerBlock - behind) {
+            streaming.remove(bytesOf(blocks.front()));
+            blocks.pop_front();
+            revision++;
+        }
+
+        // Generate blocks ahead
+        int ahead = streaming.blocksAhead(Block::SIZE);
+        while (nextBlockIndex < playerBlock + ahead && streaming.canGrow(nextBlockIndex - playerBlock)) {
+            generateNextBlock();
+        }
+    }
+
+    void checkCoinCollisions() {
+        glm::vec3 pmin, pmax;
+        player.getAABB(pmin, pmax);
+
+        for (auto& block : blocks) {
+            for (auto& coin : block.coins) {
+                if (coin.collected) continue;
+
+                const float coinRadius = 0.5f;
+                glm::vec3 cmin = coin.pos - glm::vec3(coinRadius);
+                glm::vec3 cmax = coin.pos + glm::vec3(coinRadius);
+
+                if (AABBIntersect(pmin, pmax, cmin, cmax)) {
+                    coin.collected = true;
+                    coinCount++;
+                    addEvent(WorldEventType::CoinPickup, coin.pos);
+                }
+            }
+        }
+    }
+
+    void checkBlockCollisions() {
+        glm::vec3 pmin, pmax;
+        player.getAABB(pmin, pmax);
+
+        for (auto& block : blocks) {
+            // Check wall collisions
+            auto checkWall = [&](const Wall& w) {
+                if (w.size.x < 0.1f && w.size.z < 0.1f) return;
+                glm::vec3 wmin = w.pos - w.size * 0.5f;
+                glm::vec3 wmax = w.pos + w.size * 0.5f;
+
+                player.getAABB(pmin, pmax);
+
+                if (AABBIntersect(pmin, pmax, wmin, wmax)) {
+                    // Calculate overlap on each axis
+                    float overlapX1 = wmax.x - pmin.x;
+                    float overlapX2 = pmax.x - wmin.x;
+                    float overlapZ1 = wmax.z - pmin.z;
+                    float overlapZ2 = pmax.z - wmin.z;
+
+                    float minOverlapX = (overlapX1 < overlapX2) ? overlapX1 : -overlapX2;
+                    float minOverlapZ = (overlapZ1 < overlapZ2) ? overlapZ1 : -overlapZ2;
+
+                    if (std::abs(minOverlapX) < std::abs(minOverlapZ)) {
+                        player.pos.x += minOverlapX;
+                    }
+                    else {
+                        player.pos.z += minOverlapZ;
+                    }
+                    player.getAABB(pmin, pmax);
+                }
+                };
+
+            checkWall(block.leftWall);
+            checkWall(block.rightWall);
+            if (block.hasFrontWall) {
+                checkWall(block.frontWall);
+            }
+
+            // Check obstacle collision
+            if (block.hasObstacle && !block.obstacle.hit) {
+                glm::vec3 omin, omax;
+                block.obstacle.getAABB(omin, omax);
+
+                bool shouldBlock = true;
+                if (block.obstacle.type == ObsType::SlideGate) {
+                    float barBottom = omin.y;
+                    float playerTop = pmax.y;
+                    if (player.sliding && playerTop <= barBottom + 0.01f) {
+                        shouldBlock = false;
+                    }
+                }
+                if (block.obstacle.type == ObsType::JumpWall) {
+                    float wallTop = omax.y;
+                    if (!player.onGround && player.pos.y > wallTop + 0.01f) {
+                        shouldBlock = false;
+                    }
+                }
+
+                if (AABBIntersect(pmin, pmax, omin, omax)) {
+                    if (shouldBlock) {
+                        block.obstacle.hit = true;
+                        hp -= 1;
+                        addEvent(WorldEventType::ObstacleHit, glm::clamp(player.pos, omin, omax));
+                        if (hp <= 0) gameOver = true;
+
+                        // Push player out
+                        float dx1 = omax.x - pmin.x;
+                        float dx2 = pmax.x - omin.x;
+                        float dz1 = omax.z - pmin.z;
+                        float dz2 = pmax.z - omin.z;
+                        float pushX = (dx1 < dx2 ? -dx1 : dx2);
+                        float pushZ = (dz1 < dz2 ? -dz1 : dz2);
+
+                        if (std::abs(pushZ) <= std::abs(pushX)) {
+                            player.pos.z += pushZ + (pushZ > 0 ? 0.001f : -0.001f);
+                        }
+                        else {
+                            player.pos.x += pushX + (pushX > 0 ? 0.001f : -0.001f);
+                        }
+
+                        player.getAABB(pmin, pmax);
+                    }
+                }
+            }
+        }
+    }
+};
+
+#endif
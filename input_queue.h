@@ -0,0 +1,107 @@
+#ifndef INPUT_QUEUE_H
+#define INPUT_QUEUE_H
+
+#include "input_record.h"
+
+#include <atomic>
+#include <cstdint>
+
+// One key or mouse event, stamped when it was received
+struct InputEvent {
+    double time = 0.0;      // seconds, glfwGetTime() clock
+    uint32_t button = 0;    // InputButton bit; 0 for mouse movement
+    bool down = false;
+    float mouseDx = 0.0f;
+};
+
+// Lock-free single-producer / single-consumer ring. The producer (input callbacks or an input
+// thread) only writes tail and the consumer (the simulation) only writes head, so neither side
+// ever waits. A full queue drops the newest event and counts it.
+template <typename T, unsigned int N>
+class SpscQueue {
+    static_assert((N & (N - 1)) == 0, "capacity must be a power of two");
+
+public:
+    bool push(const T& item) {
+        unsigned int tail = tailIndex.load(std::memory_order_relaxed);
+        if (tail - headIndex.load(std::memory_order_acquire) == N) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        items[tail % N] = item;
+        tailIndex.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T& item) {
+        unsigned int head = headIndex.load(std::memory_order_relaxed);
+        if (head == tailIndex.load(std::memory_order_acquire)) return false;
+        item = items[head % N];
+        headIndex.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // oldest item without removing it
+    bool peek(T& item) const {
+        unsigned int head = headIndex.load(std::memory_order_relaxed);
+        if (head == tailIndex.load(std::memory_order_acquire)) return false;
+        item = items[head % N];
+        return true;
+    }
+
+    unsigned int droppedCount() const { return dropped.load(std::memory_order_relaxed); }
+
+private:
+    T items[N];
+    alignas(64) std::atomic<unsigned int> headIndex{ 0 };
+    alignas(64) std::atomic<unsigned int> tailIndex{ 0 };
+    std::atomic<unsigned int> dropped{ 0 };
+};
+
+// Turns the event stream into one FrameInput per simulated frame. Every press between two
+// frames is kept, even one released again before the frame (a tap), together with the moment
+// it happened, so the simulation can apply it at that point of the frame instead of the start.
+class InputQueue {
+public:
+    void push(const InputEvent& e) { events.push(e); }
+
+    // Consumes the events up to 'until' (the time the frame's input was sampled). The wall
+    // time since the previous call is mapped onto dt, which differs from it in fixed-step runs.
+    FrameInput collect(double until, float dt) {
+        FrameInput input;
+        input.dt = dt;
+        double span = lastCollect >= 0.0 ? until - lastCollect : 0.0;
+        InputEvent e;
+        while (events.peek(e) && e.time <= until) {
+            events.pop(e);
+            if (e.button == 0) {
+                input.mouseDx += e.mouseDx;
+                continue;
+            }
+            if (!e.down) {
+                held &= ~e.button;
+                continue;
+            }
+            if (held & e.button) continue;   // key repeat
+            held |= e.button;
+            int slot = FrameInput::pressSlot(e.button);
+            if (!(input.pressed & e.button) && slot >= 0) {
+                float t = span > 0.0 ? (float)((e.time - lastCollect) / span) * dt : 0.0f;
+                input.pressAt[slot] = t < 0.0f ? 0.0f : (t > dt ? dt : t);
+            }
+            input.pressed |= e.button;
+        }
+        input.buttons = held;
+        lastCollect = until;
+        return input;
+    }
+
+    unsigned int dropped() const { return events.droppedCount(); }
+
+private:
+    SpscQueue<InputEvent, 1024> events;
+    uint32_t held = 0;        // consumer side only
+    double lastCollect = -1.0;
+};
+
+#endif
@@ -0,0 +1,106 @@
+#ifndef INPUT_RECORD_H
+#define INPUT_RECORD_H
+
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+enum InputButton : uint32_t {
+    INPUT_JUMP = 1u << 0,
+    INPUT_SLIDE = 1u << 1,
+    INPUT_LEFT = 1u << 2,
+    INPUT_RIGHT = 1u << 3,
+    INPUT_RESTART = 1u << 4,
+    INPUT_QUIT = 1u << 5,
+    INPUT_TOGGLE_PREPASS = 1u << 6,   // F2: depth pre-pass on/off
+    INPUT_TOGGLE_STATS = 1u << 7,     // F3: render queue stats in the title
+    INPUT_TOGGLE_QUALITY = 1u << 8,   // F4: quality governor on/off
+};
+
+// Everything the simulation reads from the player in one frame
+struct FrameInput {
+    float dt = 0.0f;        // raw frame time in seconds, before the game speed multiplier
+    float mouseDx = 0.0f;   // horizontal mouse movement in pixels
+    uint32_t buttons = 0;   // InputButton bits held at the end of the frame
+    uint32_t pressed = 0;   // InputButton bits that went down during the frame, taps included
+    float pressAt[4] = { 0.0f, 0.0f, 0.0f, 0.0f };   // jump, slide, left, right: seconds into the frame
+
+    // pressAt index of a gameplay button, -1 for the others
+    static int pressSlot(uint32_t button) {
+        switch (button) {
+        case INPUT_JUMP: return 0;
+        case INPUT_SLIDE: return 1;
+        case INPUT_LEFT: return 2;
+        case INPUT_RIGHT: return 3;
+        default: return -1;
+        }
+    }
+};
+
+// A recorded run: one FrameInput per frame. The level generator is seeded with a fixed
+// value, so replaying the inputs reproduces the run frame for frame. Recordings made before
+// presses were timestamped ("RUN1") still load; their presses count from the start of the frame.
+class InputRecording {
+public:
+    std::vector<FrameInput> frames;
+
+    bool load(const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        uint32_t magic = 0, count = 0;
+        in.read((char*)&magic, sizeof(magic));
+        in.read((char*)&count, sizeof(count));
+        if (!in || (magic != MAGIC && magic != MAGIC_V1)) {
+            std::cerr << "[Replay] " << path << " is not a run recording\n";
+            return false;
+        }
+        frames.resize(count);
+        if (magic == MAGIC) in.read((char*)frames.data(), sizeof(FrameInput) * count);
+        else {
+            uint32_t prevButtons = 0;
+            for (auto& frame : frames) {
+                FrameInputV1 old;
+                in.read((char*)&old, sizeof(old));
+                frame.dt = old.dt;
+                frame.mouseDx = old.mouseDx;
+                frame.buttons = old.buttons;
+                frame.pressed = old.buttons & ~prevButtons;
+                prevButtons = old.buttons;
+            }
+        }
+        if (!in) {
+            std::cerr << "[Replay] " << path << " is truncated\n";
+            frames.clear();
+            return false;
+        }
+        std::cout << "[Replay] " << path << ": " << count << " frames" << std::endl;
+        return true;
+    }
+
+    bool save(const std::string& path) const {
+        std::ofstream out(path, std::ios::binary);
+        if (!out) {
+            std::cerr << "[Replay] cannot write " << path << std::endl;
+            return false;
+        }
+        uint32_t magic = MAGIC, count = (uint32_t)frames.size();
+        out.write((const char*)&magic, sizeof(magic));
+        out.write((const char*)&count, sizeof(count));
+        out.write((const char*)frames.data(), sizeof(FrameInput) * count);
+        std::cout << "[Replay] recorded " << count << " frames to " << path << std::endl;
+        return (bool)out;
+    }
+
+private:
+    static const uint32_t MAGIC = 0x324E5552u;      // "RUN2"
+    static const uint32_t MAGIC_V1 = 0x314E5552u;   // "RUN1": held buttons only
+
+    struct FrameInputV1 {
+        float dt;
+        float mouseDx;
+        uint32_t buttons;
+    };
+};
+
+#endif
@@ -0,0 +1,247 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A unit of work: run(ctx, index), then pending is decremented. Jobs are plain data so the
+// queues never allocate.
+struct Job {
+    void (*run)(void* ctx, int index) = nullptr;
+    void* ctx = nullptr;
+    int index = 0;
+    std::atomic<int>* pending = nullptr;
+};
+
+// Work-stealing scheduler. Every thread (the main thread is thread 0) owns a queue: it pushes
+// and pops at the back, so nested work stays hot in its cache, while idle threads steal the
+// oldest job from the front of someone else's queue. Waiting on work never blocks a thread
+// that has anything to run: wait() keeps executing jobs until its counter drops to zero.
+// Helpers that run out of work sleep until the next push.
+class JobSystem {
+public:
+    static const int QUEUE_SIZE = 1024;
+
+    void start(int helperCount) {
+        queues = std::vector<Queue>(helperCount + 1);
+        threadIndex() = 0;
+        for (int i = 1; i <= helperCount; ++i)
+            threads.emplace_back([this, i] { workerLoop(i); });
+        std::cout << "[Jobs] " << size() << " threads" << std::endl;
+    }
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            quit = true;
+        }
+        wake.notify_all();
+        for (auto& t : threads) t.join();
+        threads.clear();
+    }
+
+    ~JobSystem() { if (!threads.empty()) stop(); }
+
+    int size() const { return (int)threads.size() + 1; }
+
+    // Queues a job on the calling thread's queue (runs it inline if the queue is full).
+    void push(const Job& job) {
+        if (queues.empty() || !queues[threadIndex()].push(job)) {
+            execute(job);
+            return;
+        }
+        queued.fetch_add(1);
+        if (sleepers.load() > 0) {
+            { std::lock_guard<std::mutex> lock(sleepMutex); }
+            wake.notify_one();
+        }
+    }
+
+    // Runs jobs until pending reaches zero.
+    void wait(const std::atomic<int>& pending) {
+        Job job;
+        while (pending.load(std::memory_order_acquire) > 0) {
+            if (take(threadIndex(), job)) execute(job);
+            else std::this_thread::yield();
+        }
+    }
+
+    // fn(0) .. fn(count - 1) as separate jobs; returns when all are done. Can be called from
+    // inside a job, the calling thread works on its own indices while others steal.
+    void parallelFor(int count, const std::function<void(int)>& fn) {
+        if (count <= 0) return;
+        std::atomic<int> pending{ count };
+        Job job;
+        job.run = [](void* ctx, int index) { (*(const std::function<void(int)>*)ctx)(index); };
+        job.ctx = (void*)&fn;
+        job.pending = &pending;
+        for (int i = count - 1; i >= 1; --i) {
+            job.index = i;
+            push(job);
+        }
+        job.index = 0;
+        execute(job);
+        wait(pending);
+    }
+
+private:
+    // Bounded deque behind a lock; contention only happens on steals.
+    struct Queue {
+        std::mutex mutex;
+        Job jobs[QUEUE_SIZE];
+        unsigned int head = 0, tail = 0;
+
+        Queue() {}
+        Queue(const Queue&) {}
+        Queue& operator=(const Queue&) { return *this; }
+
+        bool push(const Job& job) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (tail - head == QUEUE_SIZE) return false;
+            jobs[tail++ % QUEUE_SIZE] = job;
+            return true;
+        }
+        bool popBack(Job& job) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (tail == head) return false;
+            job = jobs[--tail % QUEUE_SIZE];
+            return true;
+        }
+        bool stealFront(Job& job) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (tail == head) return false;
+            job = jobs[head++ % QUEUE_SIZE];
+            return true;
+        }
+    };
+
+    static int& threadIndex() {
+        static thread_local int index = 0;
+        return index;
+    }
+
+    bool take(int self, Job& job) {
+        if (queued.load() == 0) return false;
+        bool found = queues[self].popBack(job);
+        for (int i = 1; !found && i < (int)queues.size(); ++i)
+            found = queues[(self + i) % queues.size()].stealFront(job);
+        if (found) queued.fetch_sub(1);
+        return found;
+    }
+
+    static void execute(const Job& job) {
+        job.run(job.ctx, job.index);
+        job.pending->fetch_sub(1, std::memory_order_release);
+    }
+
+    void workerLoop(int self) {
+        threadIndex() = self;
+        Job job;
+        for (;;) {
+            if (take(self, job)) {
+                execute(job);
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            sleepers.fetch_add(1);
+            wake.wait(lock, [this] { return quit || queued.load() > 0; });
+            sleepers.fetch_sub(1);
+            if (quit) return;
+        }
+    }
+
+    std::vector<Queue> queues;
+    std::vector<std::thread> threads;
+    std::atomic<int> queued{ 0 };
+    std::atomic<int> sleepers{ 0 };
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    bool quit = false;
+};
+
+// A fixed set of tasks with dependencies, built once and run every frame. A task is queued
+// as soon as the tasks it depends on have finished, on the thread that finished the last one.
+// submit() returns immediately, so the caller can do its own work (GL calls on the main
+// thread) before wait(). Per-task times of the last run are kept for profiling.
+class TaskGraph {
+public:
+    static const int MAX_TASKS = 16;
+    static const int MAX_DEPENDENTS = 8;
+    typedef int Task;
+
+    Task add(const char* name, std::function<void()> fn) {
+        Node& n = nodes[count];
+        n.name = name;
+        n.fn = std::move(fn);
+        n.dependencies = 0;
+        n.dependentCount = 0;
+        return count++;
+    }
+
+    // task starts only after before has finished
+    void depends(Task task, Task before) {
+        Node& b = nodes[before];
+        b.dependents[b.dependentCount++] = task;
+        nodes[task].dependencies++;
+    }
+
+    void submit(JobSystem& jobs) {
+        system = &jobs;
+        pending.store(count);
+        for (int i = 0; i < count; ++i) nodes[i].waiting.store(nodes[i].dependencies);
+        for (int i = 0; i < count; ++i)
+            if (nodes[i].dependencies == 0) system->push(jobFor(i));
+    }
+
+    void wait() { if (system) system->wait(pending); }
+
+    int size() const { return count; }
+    const char* name(Task task) const { return nodes[task].name; }
+    float milliseconds(Task task) const { return nodes[task].ms; }
+
+private:
+    struct Node {
+        const char* name = "";
+        std::function<void()> fn;
+        int dependencies = 0;
+        std::atomic<int> waiting{ 0 };
+        Task dependents[MAX_DEPENDENTS];
+        int dependentCount = 0;
+        float ms = 0.0f;
+    };
+
+    Job jobFor(Task task) {
+        Job job;
+        job.run = &TaskGraph::runTask;
+        job.ctx = this;
+        job.index = task;
+        job.pending = &pending;
+        return job;
+    }
+
+    static void runTask(void* ctx, int task) {
+        TaskGraph* graph = (TaskGraph*)ctx;
+        Node& n = graph->nodes[task];
+        auto start = std::chrono::steady_clock::now();
+        n.fn();
+        n.ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+        // released before this task counts as finished, so pending cannot hit zero early
+        for (int i = 0; i < n.dependentCount; ++i) {
+            Task next = n.dependents[i];
+            if (graph->nodes[next].waiting.fetch_sub(1) == 1) graph->system->push(graph->jobFor(next));
+        }
+    }
+
+    Node nodes[MAX_TASKS];
+    int count = 0;
+    std::atomic<int> pending{ 0 };
+    JobSystem* system = nullptr;
+};
+
+#endif
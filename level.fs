@@ -0,0 +1,27 @@
+#version 330 core
+#include "lighting.glsl"
+
+out vec4 FragColor;
+
+in vec2 TexCoords;
+in vec3 FragPos;
+in vec3 Normal;
+flat in int TexSlot;
+
+uniform sampler2D floorTexture;
+uniform sampler2D boxTexture;
+
+void main()
+{
+    vec4 albedo;
+    if (TexSlot == 0)
+        albedo = texture(floorTexture, TexCoords);
+    else
+        albedo = texture(boxTexture, TexCoords);
+
+    vec3 N = normalize(Normal);
+    float diff = max(dot(N, -sunDirection.xyz), 0.0);
+    float shadow = diff > 0.0 ? sunShadow(FragPos, N) : 1.0;
+    vec3 light = sunColor.rgb * (sunColor.w + diff * shadow) + pointLights(FragPos, N);
+    FragColor = vec4(albedo.rgb * light, albedo.a);
+}
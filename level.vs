@@ -0,0 +1,28 @@
+#version 330 core
+
+layout(location = 0) in vec3 pos;
+layout(location = 1) in vec3 norm;
+layout(location = 2) in vec2 tex;
+layout(location = 7) in mat4 instanceModel;
+layout(location = 11) in vec4 instanceParams;
+
+layout(std140) uniform FrameData {
+    mat4 projection;
+    mat4 view;
+    vec4 viewPos;
+    vec4 lightPos;
+};
+
+out vec2 TexCoords;
+out vec3 FragPos;
+out vec3 Normal;
+flat out int TexSlot;
+
+void main()
+{
+    TexCoords = tex;
+    TexSlot = int(instanceParams.x + 0.5);
+    FragPos = vec3(instanceModel * vec4(pos, 1.0));
+    Normal = mat3(transpose(inverse(instanceModel))) * norm;
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+}
@@ -0,0 +1,254 @@
+#ifndef LEVEL_BATCH_H
+#define LEVEL_BATCH_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Layout shared by the floor quad and the unit cube (matches the skinned shader inputs)
+struct LevelVertex {
+    float px, py, pz, nx, ny, nz, u, v, bid0, bid1, bid2, bid3, w0, w1, w2, w3;
+};
+
+// Per-piece data consumed by level.vs as instanced attributes
+struct LevelInstance {
+    glm::mat4 model;
+    glm::vec4 params;   // x = texture slot (0 floor, 1 box)
+};
+
+struct LevelBounds {
+    glm::vec4 min;   // w = occlusion group, -1 for none
+    glm::vec4 max;
+};
+
+struct DrawElementsIndirectCommand {
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint  baseVertex;
+    GLuint baseInstance;
+};
+
+// GPU-driven submission for all level geometry. Floor and box share one VBO/EBO, every
+// piece is one indirect command pointing at its own instance, and the whole level goes
+// out in a single glMultiDrawElementsIndirect. Instance and command data are rebuilt only
+// when blocks stream in or out; on GL 4.3+ a compute pass frustum-culls the commands on
+// the GPU each frame, optionally also dropping the groups of pieces that a CPU occlusion test
+// found hidden. Requires GL 4.3 (or ARB_multi_draw_indirect) at runtime; callers
+// keep the per-draw path for older contexts.
+class LevelBatch {
+public:
+    enum Mesh { MESH_FLOOR = 0, MESH_BOX = 1, MESH_COUNT };
+
+    static bool supported() {
+        return GLAD_GL_VERSION_4_3 || GLAD_GL_ARB_multi_draw_indirect;
+    }
+
+    static bool cullingSupported() {
+        return GLAD_GL_VERSION_4_3 || (GLAD_GL_ARB_compute_shader && GLAD_GL_ARB_shader_storage_buffer_object);
+    }
+
+    void init(const LevelVertex* floorVerts, int floorVertCount, const unsigned int* floorIdx, int floorIdxCount,
+              const LevelVertex* boxVerts, int boxVertCount, const unsigned int* boxIdx, int boxIdxCount,
+              const char* cullShaderPath) {
+        std::vector<LevelVertex> verts(floorVerts, floorVerts + floorVertCount);
+        verts.insert(verts.end(), boxVerts, boxVerts + boxVertCount);
+        std::vector<unsigned int> idx(floorIdx, floorIdx + floorIdxCount);
+        idx.insert(idx.end(), boxIdx, boxIdx + boxIdxCount);
+
+        meshes[MESH_FLOOR] = { (GLuint)floorIdxCount, 0, 0 };
+        meshes[MESH_BOX] = { (GLuint)boxIdxCount, (GLuint)floorIdxCount, floorVertCount };
+
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &VBO);
+        glGenBuffers(1, &EBO);
+        glGenBuffers(1, &instanceVBO);
+        glGenBuffers(1, &commandBuffer);
+        glGenBuffers(1, &boundsBuffer);
+        glGenBuffers(1, &groupBuffer);
+
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, verts.size() * sizeof(LevelVertex), verts.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, idx.size() * sizeof(unsigned int), idx.data(), GL_STATIC_DRAW);
+
+        GLsizei stride = sizeof(LevelVertex);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(LevelVertex, px));
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(LevelVertex, nx));
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(LevelVertex, u));
+
+        // instance model matrix in locations 7..10, params in 11
+        glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+        GLsizei istride = sizeof(LevelInstance);
+        for (int i = 0; i < 4; ++i) {
+            glEnableVertexAttribArray(7 + i);
+            glVertexAttribPointer(7 + i, 4, GL_FLOAT, GL_FALSE, istride, (void*)(offsetof(LevelInstance, model) + sizeof(glm::vec4) * i));
+            glVertexAttribDivisor(7 + i, 1);
+        }
+        glEnableVertexAttribArray(11);
+        glVertexAttribPointer(11, 4, GL_FLOAT, GL_FALSE, istride, (void*)offsetof(LevelInstance, params));
+        glVertexAttribDivisor(11, 1);
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        if (cullingSupported() && cullShaderPath)
+            cullProgram = compileCompute(cullShaderPath);
+    }
+
+    // Start a new level description; add() pieces, then upload().
+    void begin() {
+        instances.clear();
+        commands.clear();
+        bounds.clear();
+    }
+
+    void add(Mesh mesh, const glm::mat4& model, float texSlot, const glm::vec3& bmin, const glm::vec3& bmax, int group = -1) {
+        DrawElementsIndirectCommand cmd;
+        cmd.count = meshes[mesh].count;
+        cmd.instanceCount = 1;
+        cmd.firstIndex = meshes[mesh].firstIndex;
+        cmd.baseVertex = meshes[mesh].baseVertex;
+        cmd.baseInstance = (GLuint)instances.size();
+        commands.push_back(cmd);
+
+        LevelInstance inst;
+        inst.model = model;
+        inst.params = glm::vec4(texSlot, 0.0f, 0.0f, 0.0f);
+        instances.push_back(inst);
+
+        LevelBounds b;
+        b.min = glm::vec4(bmin, (float)group);
+        b.max = glm::vec4(bmax, 1.0f);
+        bounds.push_back(b);
+    }
+
+    void upload() {
+        uploadBuffer(GL_ARRAY_BUFFER, instanceVBO, instances.data(), instances.size() * sizeof(LevelInstance), instanceCapacity);
+        uploadBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer, commands.data(), commands.size() * sizeof(DrawElementsIndirectCommand), commandCapacity);
+        if (cullProgram)
+            uploadBuffer(GL_SHADER_STORAGE_BUFFER, boundsBuffer, bounds.data(), bounds.size() * sizeof(LevelBounds), boundsCapacity);
+        drawCount = (GLsizei)commands.size();
+    }
+
+    // Writes instanceCount = 0/1 into every command based on the six frustum planes and, when
+    // given, groupVisible[group] of the groups passed to add(). Shadow passes leave it out:
+    // occlusion is only valid from the camera.
+    void cull(const glm::vec4 planes[6], const uint8_t* groupVisible = nullptr, int groupCount = 0) {
+        if (!cullProgram || drawCount == 0) return;
+        if (!cullEnabled) {
+            // put back the instance counts the last cull pass may have zeroed
+            if (culled) upload();
+            culled = false;
+            return;
+        }
+        culled = true;
+        if (!groupVisible) groupCount = 0;
+        if (groupCount > 0) {
+            groups.assign(groupVisible, groupVisible + groupCount);
+            uploadBuffer(GL_SHADER_STORAGE_BUFFER, groupBuffer, groups.data(), groups.size() * sizeof(GLuint), groupCapacity);
+        }
+        glUseProgram(cullProgram);
+        glUniform4fv(glGetUniformLocation(cullProgram, "frustumPlanes"), 6, &planes[0].x);
+        glUniform1ui(glGetUniformLocation(cullProgram, "commandCount"), (GLuint)drawCount);
+        glUniform1ui(glGetUniformLocation(cullProgram, "groupCount"), (GLuint)groupCount);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, boundsBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, commandBuffer);
+        if (groupCount > 0) glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, groupBuffer);
+        glDispatchCompute((drawCount + 63) / 64, 1, 1);
+        glMemoryBarrier(GL_COMMAND_BARRIER_BIT);
+    }
+
+    void draw() const {
+        if (drawCount == 0) return;
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+        glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, drawCount, 0);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        glBindVertexArray(0);
+    }
+
+    GLsizei commandCount() const { return drawCount; }
+    bool hasGpuCulling() const { return cullProgram != 0; }
+
+    bool cullEnabled = true;
+
+private:
+    struct MeshRange {
+        GLuint count;
+        GLuint firstIndex;
+        GLint baseVertex;
+    };
+
+    static void uploadBuffer(GLenum target, GLuint buffer, const void* data, size_t bytes, size_t& capacity) {
+        glBindBuffer(target, buffer);
+        if (bytes > capacity) {
+            capacity = bytes * 2;
+            glBufferData(target, capacity, nullptr, GL_DYNAMIC_DRAW);
+        }
+        if (bytes > 0) glBufferSubData(target, 0, bytes, data);
+        glBindBuffer(target, 0);
+    }
+
+    static GLuint compileCompute(const char* path) {
+        std::ifstream file(path);
+        if (!file) {
+            std::cerr << "[LevelBatch] missing compute shader " << path << ", GPU culling disabled\n";
+            return 0;
+        }
+        std::stringstream ss;
+        ss << file.rdbuf();
+        std::string code = ss.str();
+        const char* src = code.c_str();
+
+        GLuint cs = glCreateShader(GL_COMPUTE_SHADER);
+        glShaderSource(cs, 1, &src, nullptr);
+        glCompileShader(cs);
+        GLint ok = 0;
+        glGetShaderiv(cs, GL_COMPILE_STATUS, &ok);
+        if (!ok) {
+            char log[1024];
+            glGetShaderInfoLog(cs, sizeof(log), nullptr, log);
+            std::cerr << "[LevelBatch] compute compile error:\n" << log << std::endl;
+            glDeleteShader(cs);
+            return 0;
+        }
+        GLuint program = glCreateProgram();
+        glAttachShader(program, cs);
+        glLinkProgram(program);
+        glDeleteShader(cs);
+        glGetProgramiv(program, GL_LINK_STATUS, &ok);
+        if (!ok) {
+            char log[1024];
+            glGetProgramInfoLog(program, sizeof(log), nullptr, log);
+            std::cerr << "[LevelBatch] compute link error:\n" << log << std::endl;
+            glDeleteProgram(program);
+            return 0;
+        }
+        return program;
+    }
+
+    MeshRange meshes[MESH_COUNT];
+    GLuint VAO = 0, VBO = 0, EBO = 0;
+    GLuint instanceVBO = 0, commandBuffer = 0, boundsBuffer = 0, groupBuffer = 0;
+    GLuint cullProgram = 0;
+    size_t instanceCapacity = 0, commandCapacity = 0, boundsCapacity = 0, groupCapacity = 0;
+    GLsizei drawCount = 0;
+    bool culled = false;
+
+    std::vector<LevelInstance> instances;
+    std::vector<DrawElementsIndirectCommand> commands;
+    std::vector<LevelBounds> bounds;
+    std::vector<GLuint> groups;
+};
+
+#endif
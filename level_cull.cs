@@ -0,0 +1,55 @@
+#version 430 core
+layout(local_size_x = 64) in;
+
+struct Bounds {
+    vec4 bmin;
+    vec4 bmax;
+};
+
+struct DrawCommand {
+    uint count;
+    uint instanceCount;
+    uint firstIndex;
+    int  baseVertex;
+    uint baseInstance;
+};
+
+layout(std430, binding = 0) readonly buffer BoundsBuffer {
+    Bounds bounds[];
+};
+
+layout(std430, binding = 1) buffer CommandBuffer {
+    DrawCommand commands[];
+};
+
+// 0 = every piece of that group is hidden behind occluders (bounds.bmin.w = group)
+layout(std430, binding = 2) readonly buffer GroupBuffer {
+    uint groupVisible[];
+};
+
+uniform vec4 frustumPlanes[6];
+uniform uint commandCount;
+uniform uint groupCount;   // 0 = no occlusion information
+
+void main()
+{
+    uint i = gl_GlobalInvocationID.x;
+    if (i >= commandCount)
+        return;
+
+    Bounds b = bounds[i];
+    bool visible = true;
+    for (int p = 0; p < 6; ++p) {
+        vec4 plane = frustumPlanes[p];
+        // corner of the box furthest along the plane normal
+        vec3 positive = mix(b.bmin.xyz, b.bmax.xyz, greaterThanEqual(plane.xyz, vec3(0.0)));
+        if (dot(plane.xyz, positive) + plane.w < 0.0) {
+            visible = false;
+            break;
+        }
+    }
+    int group = int(b.bmin.w);
+    if (visible && group >= 0 && uint(group) < groupCount)
+        visible = groupVisible[group] != 0u;
+    commands[i].instanceCount = visible ? 1u : 0u;
+}
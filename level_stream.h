@@ -0,0 +1,210 @@
+#ifndef LEVEL_STREAM_H
+#define LEVEL_STREAM_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Size of the live level window around the player: a path length in front and behind,
+// capped by a memory budget. Read from a small config file; environment variables override
+// it, so the window can shrink for low-memory devices or grow for long draw distances
+// without a rebuild.
+struct StreamingConfig {
+    float aheadDistance = 250.0f;       // path length generated in front of the player
+    float behindDistance = 50.0f;       // path length kept behind (collisions, chase camera)
+    size_t memoryBudget = 512 * 1024;   // bytes of live blocks, see StreamingBudget
+    int minBlocksAhead = 8;             // always generated, budget or not, so the run can go on
+
+    // "key = value" lines with keys ahead, behind, budget_kb, min_ahead; '#' starts a comment.
+    // A missing file keeps the defaults.
+    bool load(const std::string& path) {
+        std::ifstream in(path);
+        if (!in) return false;
+        std::string line;
+        int lineNo = 0;
+        while (std::getline(in, line)) {
+            lineNo++;
+            size_t hash = line.find('#');
+            if (hash != std::string::npos) line.erase(hash);
+            size_t eq = line.find('=');
+            if (eq == std::string::npos) {
+                if (line.find_first_not_of(" \t\r") != std::string::npos)
+                    std::cerr << "[Streaming] " << path << ":" << lineNo << ": expected key = value\n";
+                continue;
+            }
+            std::string key, value;
+            std::istringstream(line.substr(0, eq)) >> key;
+            std::istringstream(line.substr(eq + 1)) >> value;
+            if (!set(key, value))
+                std::cerr << "[Streaming] " << path << ":" << lineNo << ": unknown or invalid '" << key << "'\n";
+        }
+        return true;
+    }
+
+    // TR_STREAM_AHEAD, TR_STREAM_BEHIND, TR_STREAM_BUDGET_KB, TR_STREAM_MIN_AHEAD
+    void applyEnvironment() {
+        const char* keys[][2] = {
+            { "TR_STREAM_AHEAD", "ahead" }, { "TR_STREAM_BEHIND", "behind" },
+            { "TR_STREAM_BUDGET_KB", "budget_kb" }, { "TR_STREAM_MIN_AHEAD", "min_ahead" },
+        };
+        for (const auto& k : keys) {
+            const char* value = std::getenv(k[0]);
+            if (value && !set(k[1], value))
+                std::cerr << "[Streaming] ignoring " << k[0] << "=" << value << "\n";
+        }
+    }
+
+private:
+    bool set(const std::string& key, const std::string& value) {
+        char* end = nullptr;
+        double v = std::strtod(value.c_str(), &end);
+        if (value.empty() || *end != '\0' || v < 0.0) return false;
+        if (key == "ahead") aheadDistance = (float)v;
+        else if (key == "behind") behindDistance = (float)v;
+        else if (key == "budget_kb") memoryBudget = (size_t)(v * 1024.0);
+        else if (key == "min_ahead") minBlocksAhead = std::max(1, (int)v);
+        else return false;
+        return true;
+    }
+};
+
+// Live block accounting against the config. The caller reports each block's footprint when
+// it is generated and again when it is dropped; peaks are kept across resets.
+class StreamingBudget {
+public:
+    StreamingConfig config;
+
+    int blocksAhead(float blockSize) const {
+        return std::max(config.minBlocksAhead, (int)std::ceil(config.aheadDistance / blockSize));
+    }
+    int blocksBehind(float blockSize) const { return (int)std::ceil(config.behindDistance / blockSize); }
+
+    // Whether one more block may be generated, judged by the average block size so far.
+    // Called from the simulation tick, so hitting the budget is counted for report(), not printed.
+    bool canGrow(int blocksAheadOfPlayer) {
+        if (blocksAheadOfPlayer < config.minBlocksAhead) return true;
+        size_t average = liveBlocks > 0 ? liveBytes / liveBlocks : 0;
+        if (liveBytes + average <= config.memoryBudget) {
+            atBudget = false;
+            return true;
+        }
+        if (!atBudget) {
+            budgetHits++;
+            fewestAhead = budgetHits == 1 ? blocksAheadOfPlayer : std::min(fewestAhead, blocksAheadOfPlayer);
+            atBudget = true;
+        }
+        return false;
+    }
+
+    void add(size_t bytes) {
+        liveBlocks++;
+        liveBytes += bytes;
+        peakBlocks = std::max(peakBlocks, liveBlocks);
+        peakBytes = std::max(peakBytes, liveBytes);
+    }
+
+    void remove(size_t bytes) {
+        liveBlocks--;
+        liveBytes -= std::min(bytes, liveBytes);
+    }
+
+    void clear() {
+        liveBlocks = 0;
+        liveBytes = 0;
+    }
+
+    int blocks() const { return liveBlocks; }
+    size_t bytes() const { return liveBytes; }
+    int peakBlockCount() const { return peakBlocks; }
+    size_t peakByteCount() const { return peakBytes; }
+
+    void describe() const {
+        std::cout << "[Streaming] window " << config.aheadDistance << " ahead / " << config.behindDistance
+            << " behind, budget " << config.memoryBudget / 1024 << " KB" << std::endl;
+    }
+
+    void report() const {
+        std::cout << "[Streaming] peak " << peakBlocks << " live blocks, " << peakBytes / 1024 << " KB of "
+            << config.memoryBudget / 1024 << " KB budget" << std::endl;
+        if (budgetHits > 0)
+            std::cout << "[Streaming] memory budget reached " << budgetHits << " times, as early as " << fewestAhead
+                << " blocks ahead" << std::endl;
+    }
+
+private:
+    int liveBlocks = 0, peakBlocks = 0;
+    size_t liveBytes = 0, peakBytes = 0;
+    int budgetHits = 0;     // times generation stopped at the budget, consecutive refusals counted once
+    int fewestAhead = 0;    // blocks ahead of the player at the earliest of those stops
+    bool atBudget = false;
+};
+
+// Storage of the live window: a ring of slots reused as blocks stream in at the back and out
+// at the front, so steady-state streaming and restarts never allocate. It only grows if the
+// window outruns the reserved slots.
+template <typename T>
+class WindowRing {
+public:
+    template <typename Ring, typename V>
+    class Iter {
+    public:
+        Iter(Ring* ring, size_t i) : ring(ring), i(i) {}
+        V& operator*() const { return (*ring)[i]; }
+        V* operator->() const { return &(*ring)[i]; }
+        Iter& operator++() { ++i; return *this; }
+        bool operator!=(const Iter& other) const { return i != other.i; }
+    private:
+        Ring* ring;
+        size_t i;
+    };
+    typedef Iter<WindowRing, T> iterator;
+    typedef Iter<const WindowRing, const T> const_iterator;
+
+    void reserve(size_t n) {
+        if (n <= slots.size()) return;
+        std::vector<T> grown(n);
+        for (size_t i = 0; i < count; ++i) grown[i] = (*this)[i];
+        slots.swap(grown);
+        head = 0;
+    }
+
+    void push_back(const T& value) {
+        if (count == slots.size()) reserve(std::max<size_t>(16, slots.size() * 2));
+        slots[(head + count) % slots.size()] = value;
+        count++;
+    }
+
+    void pop_front() {
+        head = (head + 1) % slots.size();
+        count--;
+    }
+
+    void clear() { head = count = 0; }
+
+    bool empty() const { return count == 0; }
+    size_t size() const { return count; }
+    size_t capacity() const { return slots.size(); }
+
+    T& operator[](size_t i) { return slots[(head + i) % slots.size()]; }
+    const T& operator[](size_t i) const { return slots[(head + i) % slots.size()]; }
+    T& front() { return (*this)[0]; }
+    const T& front() const { return (*this)[0]; }
+    T& back() { return (*this)[count - 1]; }
+    const T& back() const { return (*this)[count - 1]; }
+
+    iterator begin() { return iterator(this, 0); }
+    iterator end() { return iterator(this, count); }
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, count); }
+
+private:
+    std::vector<T> slots;
+    size_t head = 0, count = 0;
+};
+
+#endif
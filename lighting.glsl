@@ -0,0 +1,81 @@
+// Sun, shadow and clustered point-light lighting shared by the lit fragment shaders
+// (level.fs, anim_model.fs, static_model.fs). ShaderCache splices it in where a shader says
+// #include "lighting.glsl", right after its #version line; it declares FrameData for them.
+
+layout(std140) uniform FrameData {
+    mat4 projection;
+    mat4 view;
+    vec4 viewPos;
+    vec4 lightPos;
+};
+
+// directional sun and its cascaded shadow maps
+layout(std140) uniform ShadowData {
+    mat4 lightViewProj[3];
+    vec4 cascadeSplits;    // xyz = view-space far distance per cascade, w = fade start
+    vec4 cascadeTexel;     // world size of one shadow texel per cascade
+    vec4 sunDirection;     // xyz = direction the light travels
+    vec4 sunColor;         // rgb, w = ambient strength
+};
+
+uniform sampler2DArrayShadow shadowMap;
+
+float sunShadow(vec3 worldPos, vec3 N)
+{
+    float depth = -(view * vec4(worldPos, 1.0)).z;
+    if (depth >= cascadeSplits.z)
+        return 1.0;
+    int c = depth < cascadeSplits.x ? 0 : (depth < cascadeSplits.y ? 1 : 2);
+
+    // normal offset keeps lit surfaces from shadowing themselves
+    vec4 lp = lightViewProj[c] * vec4(worldPos + N * cascadeTexel[c] * 1.5, 1.0);
+    vec3 uvz = lp.xyz * 0.5 + 0.5;
+
+    vec2 texel = 1.0 / vec2(textureSize(shadowMap, 0).xy);
+    float lit = 0.0;
+    lit += texture(shadowMap, vec4(uvz.xy + vec2(-0.5, -0.5) * texel, float(c), uvz.z));
+    lit += texture(shadowMap, vec4(uvz.xy + vec2( 0.5, -0.5) * texel, float(c), uvz.z));
+    lit += texture(shadowMap, vec4(uvz.xy + vec2(-0.5,  0.5) * texel, float(c), uvz.z));
+    lit += texture(shadowMap, vec4(uvz.xy + vec2( 0.5,  0.5) * texel, float(c), uvz.z));
+    lit *= 0.25;
+
+    float fade = clamp((depth - cascadeSplits.w) / (cascadeSplits.z - cascadeSplits.w), 0.0, 1.0);
+    return mix(lit, 1.0, fade);
+}
+
+// clustered point lights (torches, glowing coins)
+layout(std140) uniform ClusterData {
+    vec4 clusterParams;   // xy = tiles per pixel, z = slice scale, w = depth of the first slice
+    vec4 clusterRange;    // x = depth of the last slice
+    ivec4 clusterDims;    // x, y = tiles, z = slices
+    ivec4 clusterBases;   // x = first light texel, y = first grid texel, z = first index texel
+};
+
+uniform samplerBuffer lightData;      // 2 texels per light: xyz + radius, rgb
+uniform usamplerBuffer clusterLists;  // (first index, count) per cluster, then light indices
+
+vec3 pointLights(vec3 worldPos, vec3 N)
+{
+    float depth = -(view * vec4(worldPos, 1.0)).z;
+    if (depth >= clusterRange.x)
+        return vec3(0.0);
+    int slice = depth <= clusterParams.w ? 0 : min(int(log(depth / clusterParams.w) * clusterParams.z), clusterDims.z - 1);
+    ivec2 tile = min(ivec2(gl_FragCoord.xy * clusterParams.xy), clusterDims.xy - 1);
+    int cluster = (slice * clusterDims.y + tile.y) * clusterDims.x + tile.x;
+
+    int first = int(texelFetch(clusterLists, clusterBases.y + cluster * 2).r);
+    int count = int(texelFetch(clusterLists, clusterBases.y + cluster * 2 + 1).r);
+
+    vec3 result = vec3(0.0);
+    for (int i = 0; i < count; ++i) {
+        int light = int(texelFetch(clusterLists, clusterBases.z + first + i).r);
+        vec4 posRadius = texelFetch(lightData, clusterBases.x + light * 2);
+        vec3 color = texelFetch(lightData, clusterBases.x + light * 2 + 1).rgb;
+
+        vec3 L = posRadius.xyz - worldPos;
+        float d2 = max(dot(L, L), 1e-4);
+        float window = clamp(1.0 - d2 / (posRadius.w * posRadius.w), 0.0, 1.0);
+        result += color * (window * window / (1.0 + d2)) * max(dot(N, L * inversesqrt(d2)), 0.0);
+    }
+    return result;
+}
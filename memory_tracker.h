@@ -0,0 +1,448 @@
+#ifndef MEMORY_TRACKER_H
+#define MEMORY_TRACKER_H
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <new>
+#include <unordered_map>
+#include <vector>
+
+// Heap and GPU memory accounting for budgets and allocation regressions.
+//
+// Heap: the global operator new/delete are replaced (in the translation unit that defines
+// MEMORY_TRACKER_IMPLEMENTATION before including this header) and every allocation is charged
+// to the calling thread's current tag, set with MemoryScope. A small header in front of each
+// block remembers its size and tag, so frees go back to the tag that allocated.
+//
+// GPU: GpuMemoryTracker::install() wraps GLAD's allocation entry points (buffer data and
+// storage, texture images and storage, mipmaps, renderbuffers, deletes) and keeps the size of
+// every buffer, texture and renderbuffer, including those created by the model loader.
+// Sizes are estimates from the internal format; drivers may pad.
+
+enum class MemTag : uint8_t {
+    General,
+    Assets,      // models, textures, animations while loading
+    World,       // simulation and level generation
+    Render,      // render queue, culling, batches
+    Animation,   // per-frame bone palettes
+    Count
+};
+
+inline const char* memTagName(MemTag tag) {
+    static const char* names[] = { "general", "assets", "world", "render", "animation" };
+    return names[(int)tag];
+}
+
+// tag charged for allocations made by this thread
+inline MemTag& currentMemTag() {
+    static thread_local MemTag tag = MemTag::General;
+    return tag;
+}
+
+class MemoryScope {
+public:
+    explicit MemoryScope(MemTag tag) : previous(currentMemTag()) { currentMemTag() = tag; }
+    ~MemoryScope() { currentMemTag() = previous; }
+    MemoryScope(const MemoryScope&) = delete;
+    MemoryScope& operator=(const MemoryScope&) = delete;
+
+private:
+    MemTag previous;
+};
+
+class HeapTracker {
+public:
+    struct Tag {
+        std::atomic<long long> bytes{ 0 };
+        std::atomic<long long> peak{ 0 };
+        std::atomic<long long> allocations{ 0 };
+    };
+
+    void onAlloc(MemTag tag, size_t size) {
+        Tag& t = tags[(int)tag];
+        raisePeak(t.peak, t.bytes.fetch_add((long long)size, std::memory_order_relaxed) + (long long)size);
+        t.allocations.fetch_add(1, std::memory_order_relaxed);
+        raisePeak(peakBytes, totalBytes.fetch_add((long long)size, std::memory_order_relaxed) + (long long)size);
+        allocationCount.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void onFree(MemTag tag, size_t size) {
+        tags[(int)tag].bytes.fetch_sub((long long)size, std::memory_order_relaxed);
+        totalBytes.fetch_sub((long long)size, std::memory_order_relaxed);
+    }
+
+    // Called once per frame on the main thread; allocations on any thread since the last call.
+    long long endFrame() {
+        long long now = allocationCount.load(std::memory_order_relaxed);
+        frameAllocations = now - frameMark;
+        frameMark = now;
+        return frameAllocations;
+    }
+
+    long long bytes() const { return totalBytes.load(std::memory_order_relaxed); }
+    long long peak() const { return peakBytes.load(std::memory_order_relaxed); }
+    long long allocations() const { return allocationCount.load(std::memory_order_relaxed); }
+    long long lastFrameAllocations() const { return frameAllocations; }
+    const Tag& tag(MemTag t) const { return tags[(int)t]; }
+
+    void report() const {
+        std::printf("[Memory] heap %.2f MB (peak %.2f MB), %lld allocations\n",
+            bytes() / 1048576.0, peak() / 1048576.0, allocations());
+        for (int i = 0; i < (int)MemTag::Count; ++i) {
+            const Tag& t = tags[i];
+            std::printf("[Memory]   %-9s %8.2f MB (peak %.2f MB) %10lld allocations\n", memTagName((MemTag)i),
+                t.bytes.load() / 1048576.0, t.peak.load() / 1048576.0, t.allocations.load());
+        }
+    }
+
+private:
+    static void raisePeak(std::atomic<long long>& peak, long long value) {
+        long long seen = peak.load(std::memory_order_relaxed);
+        while (value > seen && !peak.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {}
+    }
+
+    Tag tags[(int)MemTag::Count];
+    std::atomic<long long> totalBytes{ 0 };
+    std::atomic<long long> peakBytes{ 0 };
+    std::atomic<long long> allocationCount{ 0 };
+    long long frameMark = 0;        // main thread only
+    long long frameAllocations = 0;
+};
+
+extern HeapTracker gHeap;
+
+class GpuMemoryTracker {
+public:
+    enum Kind { BUFFER, TEXTURE, RENDERBUFFER, KIND_COUNT };
+
+    void install();
+
+    long long bytes(Kind kind) const { return totals[kind]; }
+    long long total() const { return totals[BUFFER] + totals[TEXTURE] + totals[RENDERBUFFER]; }
+    int count(Kind kind) const {
+        return kind == BUFFER ? (int)buffers.size() : kind == TEXTURE ? (int)textureBytes().size() : (int)renderbuffers.size();
+    }
+
+    void report(int largest = 8) const {
+        static const char* kinds[] = { "buffer", "texture", "renderbuffer" };
+        std::printf("[GPU memory] %.2f MB: buffers %.2f MB (%d), textures %.2f MB (%d), renderbuffers %.2f MB (%d)\n",
+            total() / 1048576.0, totals[BUFFER] / 1048576.0, count(BUFFER), totals[TEXTURE] / 1048576.0, count(TEXTURE),
+            totals[RENDERBUFFER] / 1048576.0, count(RENDERBUFFER));
+
+        struct Item { Kind kind; GLuint id; long long bytes; };
+        std::vector<Item> items;
+        for (const auto& b : buffers) items.push_back({ BUFFER, b.first, b.second });
+        for (const auto& t : textureBytes()) items.push_back({ TEXTURE, t.first, t.second });
+        for (const auto& r : renderbuffers) items.push_back({ RENDERBUFFER, r.first, r.second });
+        std::sort(items.begin(), items.end(), [](const Item& a, const Item& b) { return a.bytes > b.bytes; });
+        for (int i = 0; i < (int)items.size() && i < largest; ++i)
+            std::printf("[GPU memory]   %-12s %4u %8.2f MB\n", kinds[items[i].kind], items[i].id, items[i].bytes / 1048576.0);
+    }
+
+    // hooks
+    void setBuffer(GLenum target, long long size);
+    void deleteBuffers(GLsizei n, const GLuint* ids);
+    void setTextureLevel(GLenum target, GLint level, long long size);
+    void addMipmaps(GLenum target);
+    void deleteTextures(GLsizei n, const GLuint* ids);
+    void setRenderbuffer(long long size);
+    void deleteRenderbuffers(GLsizei n, const GLuint* ids);
+
+    static long long bytesPerPixel(GLenum internalFormat);
+
+private:
+    // texture levels keyed by id << 32 | face << 16 | level; MIPMAPS stands for generated levels
+    static const uint32_t MIPMAPS = 0xFFFF;
+    static uint64_t levelKey(GLuint id, uint32_t face, uint32_t level) { return (uint64_t)id << 32 | face << 16 | level; }
+
+    std::map<GLuint, long long> textureBytes() const {
+        std::map<GLuint, long long> sizes;
+        for (const auto& l : textureLevels) sizes[(GLuint)(l.first >> 32)] += l.second;
+        return sizes;
+    }
+
+    void set(long long& slot, Kind kind, long long size) {
+        totals[kind] += size - slot;
+        slot = size;
+    }
+
+    std::unordered_map<GLuint, long long> buffers;
+    std::map<uint64_t, long long> textureLevels;
+    std::unordered_map<GLuint, long long> renderbuffers;
+    long long totals[KIND_COUNT] = { 0, 0, 0 };
+};
+
+extern GpuMemoryTracker gGpuMemory;
+
+#ifdef MEMORY_TRACKER_IMPLEMENTATION
+HeapTracker gHeap;
+GpuMemoryTracker gGpuMemory;
+
+// ------------- heap hooks ------------------
+// 16 bytes in front of every block; offset leads back to the malloc'd address
+struct AllocHeader {
+    uint64_t size;
+    uint32_t tag;
+    uint32_t offset;
+};
+static_assert(sizeof(AllocHeader) == 16, "allocation header must keep 16-byte alignment");
+
+static void* trackedAlloc(size_t size, size_t align) {
+    if (align < sizeof(AllocHeader)) align = sizeof(AllocHeader);
+    if (size > SIZE_MAX - align) return nullptr;   // header and padding would wrap around
+    char* raw = (char*)std::malloc(size + align);
+    if (!raw) return nullptr;
+    uintptr_t user = ((uintptr_t)raw + sizeof(AllocHeader) + align - 1) & ~(uintptr_t)(align - 1);
+    AllocHeader* h = (AllocHeader*)user - 1;
+    MemTag tag = currentMemTag();
+    h->size = size;
+    h->tag = (uint32_t)tag;
+    h->offset = (uint32_t)(user - (uintptr_t)raw);
+    gHeap.onAlloc(tag, size);
+    return (void*)user;
+}
+
+static void trackedFree(void* p) {
+    if (!p) return;
+    AllocHeader* h = (AllocHeader*)p - 1;
+    gHeap.onFree((MemTag)h->tag, (size_t)h->size);
+    std::free((char*)p - h->offset);
+}
+
+static void* trackedNew(size_t size, size_t align) {
+    void* p = trackedAlloc(size ? size : 1, align);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new(size_t size) { return trackedNew(size, 16); }
+void* operator new[](size_t size) { return trackedNew(size, 16); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return trackedAlloc(size ? size : 1, 16); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return trackedAlloc(size ? size : 1, 16); }
+void operator delete(void* p) noexcept { trackedFree(p); }
+void operator delete[](void* p) noexcept { trackedFree(p); }
+void operator delete(void* p, size_t) noexcept { trackedFree(p); }
+void operator delete[](void* p, size_t) noexcept { trackedFree(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { trackedFree(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { trackedFree(p); }
+#ifdef __cpp_aligned_new
+void* operator new(size_t size, std::align_val_t align) { return trackedNew(size, (size_t)align); }
+void* operator new[](size_t size, std::align_val_t align) { return trackedNew(size, (size_t)align); }
+void* operator new(size_t size, std::align_val_t align, const std::nothrow_t&) noexcept { return trackedAlloc(size ? size : 1, (size_t)align); }
+void* operator new[](size_t size, std::align_val_t align, const std::nothrow_t&) noexcept { return trackedAlloc(size ? size : 1, (size_t)align); }
+void operator delete(void* p, std::align_val_t) noexcept { trackedFree(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { trackedFree(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { trackedFree(p); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept { trackedFree(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { trackedFree(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { trackedFree(p); }
+#endif
+
+// ------------- GL hooks ------------------
+static PFNGLBUFFERDATAPROC realBufferData;
+static PFNGLBUFFERSTORAGEPROC realBufferStorage;
+static PFNGLDELETEBUFFERSPROC realDeleteBuffers;
+static PFNGLTEXIMAGE2DPROC realTexImage2D;
+static PFNGLTEXIMAGE3DPROC realTexImage3D;
+static PFNGLTEXSTORAGE2DPROC realTexStorage2D;
+static PFNGLTEXSTORAGE3DPROC realTexStorage3D;
+static PFNGLGENERATEMIPMAPPROC realGenerateMipmap;
+static PFNGLDELETETEXTURESPROC realDeleteTextures;
+static PFNGLRENDERBUFFERSTORAGEPROC realRenderbufferStorage;
+static PFNGLRENDERBUFFERSTORAGEMULTISAMPLEPROC realRenderbufferStorageMultisample;
+static PFNGLDELETERENDERBUFFERSPROC realDeleteRenderbuffers;
+
+static void APIENTRY hookBufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage) {
+    realBufferData(target, size, data, usage);
+    gGpuMemory.setBuffer(target, (long long)size);
+}
+static void APIENTRY hookBufferStorage(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags) {
+    realBufferStorage(target, size, data, flags);
+    gGpuMemory.setBuffer(target, (long long)size);
+}
+static void APIENTRY hookDeleteBuffers(GLsizei n, const GLuint* ids) {
+    gGpuMemory.deleteBuffers(n, ids);
+    realDeleteBuffers(n, ids);
+}
+static void APIENTRY hookTexImage2D(GLenum target, GLint level, GLint internalFormat, GLsizei width, GLsizei height,
+                                    GLint border, GLenum format, GLenum type, const void* pixels) {
+    realTexImage2D(target, level, internalFormat, width, height, border, format, type, pixels);
+    gGpuMemory.setTextureLevel(target, level, (long long)width * height * GpuMemoryTracker::bytesPerPixel((GLenum)internalFormat));
+}
+static void APIENTRY hookTexImage3D(GLenum target, GLint level, GLint internalFormat, GLsizei width, GLsizei height,
+                                    GLsizei depth, GLint border, GLenum format, GLenum type, const void* pixels) {
+    realTexImage3D(target, level, internalFormat, width, height, depth, border, format, type, pixels);
+    gGpuMemory.setTextureLevel(target, level, (long long)width * height * depth * GpuMemoryTracker::bytesPerPixel((GLenum)internalFormat));
+}
+static void APIENTRY hookTexStorage2D(GLenum target, GLsizei levels, GLenum internalFormat, GLsizei width, GLsizei height) {
+    realTexStorage2D(target, levels, internalFormat, width, height);
+    int faces = target == GL_TEXTURE_CUBE_MAP ? 6 : 1;
+    for (GLint l = 0; l < levels; ++l)
+        gGpuMemory.setTextureLevel(target, l, (long long)faces * std::max(1, width >> l) * std::max(1, height >> l) * GpuMemoryTracker::bytesPerPixel(internalFormat));
+}
+static void APIENTRY hookTexStorage3D(GLenum target, GLsizei levels, GLenum internalFormat, GLsizei width, GLsizei height, GLsizei depth) {
+    realTexStorage3D(target, levels, internalFormat, width, height, depth);
+    for (GLint l = 0; l < levels; ++l)
+        gGpuMemory.setTextureLevel(target, l, (long long)std::max(1, width >> l) * std::max(1, height >> l) * depth * GpuMemoryTracker::bytesPerPixel(internalFormat));
+}
+static void APIENTRY hookGenerateMipmap(GLenum target) {
+    realGenerateMipmap(target);
+    gGpuMemory.addMipmaps(target);
+}
+static void APIENTRY hookDeleteTextures(GLsizei n, const GLuint* ids) {
+    gGpuMemory.deleteTextures(n, ids);
+    realDeleteTextures(n, ids);
+}
+static void APIENTRY hookRenderbufferStorage(GLenum target, GLenum internalFormat, GLsizei width, GLsizei height) {
+    realRenderbufferStorage(target, internalFormat, width, height);
+    gGpuMemory.setRenderbuffer((long long)width * height * GpuMemoryTracker::bytesPerPixel(internalFormat));
+}
+static void APIENTRY hookRenderbufferStorageMultisample(GLenum target, GLsizei samples, GLenum internalFormat, GLsizei width, GLsizei height) {
+    realRenderbufferStorageMultisample(target, samples, internalFormat, width, height);
+    gGpuMemory.setRenderbuffer((long long)std::max(1, (int)samples) * width * height * GpuMemoryTracker::bytesPerPixel(internalFormat));
+}
+static void APIENTRY hookDeleteRenderbuffers(GLsizei n, const GLuint* ids) {
+    gGpuMemory.deleteRenderbuffers(n, ids);
+    realDeleteRenderbuffers(n, ids);
+}
+
+// Call right after gladLoadGL; entry points the context lacks stay unhooked.
+void GpuMemoryTracker::install() {
+#define MEMORY_HOOK(name) if (glad_gl##name && !real##name) { real##name = glad_gl##name; glad_gl##name = hook##name; }
+    MEMORY_HOOK(BufferData)
+    MEMORY_HOOK(BufferStorage)
+    MEMORY_HOOK(DeleteBuffers)
+    MEMORY_HOOK(TexImage2D)
+    MEMORY_HOOK(TexImage3D)
+    MEMORY_HOOK(TexStorage2D)
+    MEMORY_HOOK(TexStorage3D)
+    MEMORY_HOOK(GenerateMipmap)
+    MEMORY_HOOK(DeleteTextures)
+    MEMORY_HOOK(RenderbufferStorage)
+    MEMORY_HOOK(RenderbufferStorageMultisample)
+    MEMORY_HOOK(DeleteRenderbuffers)
+#undef MEMORY_HOOK
+}
+
+static GLuint boundBuffer(GLenum target) {
+    GLenum binding;
+    switch (target) {
+    case GL_ARRAY_BUFFER: binding = GL_ARRAY_BUFFER_BINDING; break;
+    case GL_ELEMENT_ARRAY_BUFFER: binding = GL_ELEMENT_ARRAY_BUFFER_BINDING; break;
+    case GL_UNIFORM_BUFFER: binding = GL_UNIFORM_BUFFER_BINDING; break;
+    case GL_TEXTURE_BUFFER: binding = GL_TEXTURE_BUFFER_BINDING; break;
+    case GL_COPY_READ_BUFFER: binding = GL_COPY_READ_BUFFER_BINDING; break;
+    case GL_COPY_WRITE_BUFFER: binding = GL_COPY_WRITE_BUFFER_BINDING; break;
+    case GL_PIXEL_PACK_BUFFER: binding = GL_PIXEL_PACK_BUFFER_BINDING; break;
+    case GL_PIXEL_UNPACK_BUFFER: binding = GL_PIXEL_UNPACK_BUFFER_BINDING; break;
+    case GL_TRANSFORM_FEEDBACK_BUFFER: binding = GL_TRANSFORM_FEEDBACK_BUFFER_BINDING; break;
+    case GL_DRAW_INDIRECT_BUFFER: binding = GL_DRAW_INDIRECT_BUFFER_BINDING; break;
+    case GL_SHADER_STORAGE_BUFFER: binding = GL_SHADER_STORAGE_BUFFER_BINDING; break;
+    default: return 0;
+    }
+    GLint id = 0;
+    glGetIntegerv(binding, &id);
+    return (GLuint)id;
+}
+
+// bound texture and cube face for a texture image target
+static GLuint boundTexture(GLenum target, uint32_t& face) {
+    GLenum binding;
+    face = 0;
+    if (target >= GL_TEXTURE_CUBE_MAP_POSITIVE_X && target <= GL_TEXTURE_CUBE_MAP_NEGATIVE_Z) {
+        face = target - GL_TEXTURE_CUBE_MAP_POSITIVE_X + 1;
+        binding = GL_TEXTURE_BINDING_CUBE_MAP;
+    }
+    else switch (target) {
+    case GL_TEXTURE_2D: binding = GL_TEXTURE_BINDING_2D; break;
+    case GL_TEXTURE_CUBE_MAP: binding = GL_TEXTURE_BINDING_CUBE_MAP; break;
+    case GL_TEXTURE_2D_ARRAY: binding = GL_TEXTURE_BINDING_2D_ARRAY; break;
+    case GL_TEXTURE_3D: binding = GL_TEXTURE_BINDING_3D; break;
+    case GL_TEXTURE_RECTANGLE: binding = GL_TEXTURE_BINDING_RECTANGLE; break;
+    default: return 0;   // proxies
+    }
+    GLint id = 0;
+    glGetIntegerv(binding, &id);
+    return (GLuint)id;
+}
+
+void GpuMemoryTracker::setBuffer(GLenum target, long long size) {
+    GLuint id = boundBuffer(target);
+    if (id) set(buffers[id], BUFFER, size);
+}
+
+void GpuMemoryTracker::deleteBuffers(GLsizei n, const GLuint* ids) {
+    for (GLsizei i = 0; i < n; ++i) {
+        auto it = buffers.find(ids[i]);
+        if (it == buffers.end()) continue;
+        totals[BUFFER] -= it->second;
+        buffers.erase(it);
+    }
+}
+
+void GpuMemoryTracker::setTextureLevel(GLenum target, GLint level, long long size) {
+    uint32_t face;
+    GLuint id = boundTexture(target, face);
+    if (id) set(textureLevels[levelKey(id, face, (uint32_t)level)], TEXTURE, size);
+}
+
+// a full chain adds about a third of the base level; storage textures already have theirs
+void GpuMemoryTracker::addMipmaps(GLenum target) {
+    uint32_t face;
+    GLuint id = boundTexture(target, face);
+    if (!id) return;
+    long long base = 0;
+    for (auto it = textureLevels.lower_bound(levelKey(id, 0, 0)); it != textureLevels.end() && (it->first >> 32) == id; ++it) {
+        uint32_t level = (uint32_t)(it->first & 0xFFFF);
+        if (level == 0) base += it->second;
+        else if (level != MIPMAPS) return;
+    }
+    set(textureLevels[levelKey(id, 0, MIPMAPS)], TEXTURE, base / 3);
+}
+
+void GpuMemoryTracker::deleteTextures(GLsizei n, const GLuint* ids) {
+    for (GLsizei i = 0; i < n; ++i) {
+        auto it = textureLevels.lower_bound(levelKey(ids[i], 0, 0));
+        while (it != textureLevels.end() && (it->first >> 32) == ids[i]) {
+            totals[TEXTURE] -= it->second;
+            it = textureLevels.erase(it);
+        }
+    }
+}
+
+void GpuMemoryTracker::setRenderbuffer(long long size) {
+    GLint id = 0;
+    glGetIntegerv(GL_RENDERBUFFER_BINDING, &id);
+    if (id) set(renderbuffers[(GLuint)id], RENDERBUFFER, size);
+}
+
+void GpuMemoryTracker::deleteRenderbuffers(GLsizei n, const GLuint* ids) {
+    for (GLsizei i = 0; i < n; ++i) {
+        auto it = renderbuffers.find(ids[i]);
+        if (it == renderbuffers.end()) continue;
+        totals[RENDERBUFFER] -= it->second;
+        renderbuffers.erase(it);
+    }
+}
+
+long long GpuMemoryTracker::bytesPerPixel(GLenum internalFormat) {
+    switch (internalFormat) {
+    case GL_RED: case GL_R8: return 1;
+    case GL_RG: case GL_RG8: case GL_R16F: case GL_DEPTH_COMPONENT16: return 2;
+    case GL_RGB: case GL_RGB8: case GL_SRGB8: return 3;
+    case GL_RGB16F: return 6;
+    case GL_RGBA16F: case GL_RG32F: return 8;
+    case GL_RGB32F: return 12;
+    case GL_RGBA32F: case GL_RGBA32UI: return 16;
+    default: return 4;   // RGBA8, depth 24/32, depth-stencil, 32-bit single channel
+    }
+}
+#endif
+
+#endif
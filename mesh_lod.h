@@ -0,0 +1,214 @@
+#ifndef MESH_LOD_H
+#define MESH_LOD_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <learnopengl/model_animation.h>
+
+#include "camera_rig.h"
+
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct LodVertex {
+    glm::vec3 pos;
+    glm::vec3 normal;
+    glm::vec2 uv;
+};
+
+struct LodMeshData {
+    std::vector<LodVertex> vertices;
+    std::vector<unsigned int> indices;
+};
+
+// Vertex-clustering simplification: snap every vertex to a grid cell, merge each cell into
+// its average vertex and drop triangles that collapse. Cheap, robust on any input and good
+// enough for small props seen from far away.
+inline LodMeshData SimplifyByClustering(const LodMeshData& src, int gridResolution) {
+    LodMeshData out;
+    if (src.vertices.empty() || gridResolution < 1) return out;
+
+    glm::vec3 bmin = src.vertices[0].pos, bmax = src.vertices[0].pos;
+    for (const auto& v : src.vertices) {
+        bmin = glm::min(bmin, v.pos);
+        bmax = glm::max(bmax, v.pos);
+    }
+    glm::vec3 extent = bmax - bmin;
+    float cell = std::fmax(extent.x, std::fmax(extent.y, extent.z)) / (float)gridResolution;
+    if (cell <= 0.0f) cell = 1.0f;
+
+    std::unordered_map<uint64_t, unsigned int> cellToVertex;
+    std::vector<unsigned int> remap(src.vertices.size());
+    std::vector<float> weight;
+
+    for (size_t i = 0; i < src.vertices.size(); ++i) {
+        const LodVertex& v = src.vertices[i];
+        uint64_t cx = (uint64_t)((v.pos.x - bmin.x) / cell);
+        uint64_t cy = (uint64_t)((v.pos.y - bmin.y) / cell);
+        uint64_t cz = (uint64_t)((v.pos.z - bmin.z) / cell);
+        uint64_t key = (cx << 42) | (cy << 21) | cz;
+
+        auto it = cellToVertex.find(key);
+        if (it == cellToVertex.end()) {
+            unsigned int id = (unsigned int)out.vertices.size();
+            cellToVertex.emplace(key, id);
+            out.vertices.push_back(v);
+            weight.push_back(1.0f);
+            remap[i] = id;
+        }
+        else {
+            LodVertex& acc = out.vertices[it->second];
+            acc.pos += v.pos;
+            acc.normal += v.normal;
+            weight[it->second] += 1.0f;
+            remap[i] = it->second;
+        }
+    }
+    for (size_t i = 0; i < out.vertices.size(); ++i) {
+        out.vertices[i].pos = out.vertices[i].pos / weight[i];
+        float len = glm::length(out.vertices[i].normal);
+        if (len > 0.0f) out.vertices[i].normal = out.vertices[i].normal / len;
+    }
+
+    for (size_t t = 0; t + 2 < src.indices.size(); t += 3) {
+        unsigned int a = remap[src.indices[t]];
+        unsigned int b = remap[src.indices[t + 1]];
+        unsigned int c = remap[src.indices[t + 2]];
+        if (a == b || b == c || a == c) continue;
+        out.indices.push_back(a);
+        out.indices.push_back(b);
+        out.indices.push_back(c);
+    }
+    return out;
+}
+
+// Discrete LODs for a static Model plus a billboard impostor for the far range.
+// LOD 0 is the source mesh merged into one draw, LODs 1..N are clustered at cook time and
+// cached next to the asset so later launches skip the simplification.
+// LOD selection, thresholds and bounds come from ScreenSizeLod (camera_rig.h).
+class ModelLod : public ScreenSizeLod {
+public:
+    void build(Model& model, const std::string& cachePath) {
+        LodMeshData source;
+        for (const auto& mesh : model.meshes) {
+            unsigned int base = (unsigned int)source.vertices.size();
+            for (const auto& v : mesh.vertices)
+                source.vertices.push_back({ v.Position, v.Normal, v.TexCoords });
+            for (unsigned int i : mesh.indices)
+                source.indices.push_back(base + i);
+        }
+
+        glm::vec3 bmin(0.0f), bmax(0.0f);
+        if (!source.vertices.empty()) {
+            bmin = bmax = source.vertices[0].pos;
+            for (const auto& v : source.vertices) {
+                bmin = glm::min(bmin, v.pos);
+                bmax = glm::max(bmax, v.pos);
+            }
+        }
+        center = (bmin + bmax) * 0.5f;
+        radius = glm::length(bmax - bmin) * 0.5f;
+
+        std::vector<LodMeshData> lods;
+        uint32_t sourceKey[2] = { (uint32_t)source.vertices.size(), (uint32_t)source.indices.size() };
+        if (!loadCache(cachePath, sourceKey, lods)) {
+            lods.clear();
+            lods.push_back(source);
+            const int grids[] = { 24, 10 };
+            for (int grid : grids)
+                lods.push_back(SimplifyByClustering(source, grid));
+            saveCache(cachePath, sourceKey, lods);
+        }
+
+        available = 0;
+        for (int i = 0; i < MAX_LODS && i < (int)lods.size(); ++i) {
+            upload(levels[i], lods[i]);
+            if (levels[i].indexCount > 0) available |= 1u << i;
+            std::cout << "[LOD] " << cachePath << " lod" << i << ": " << levels[i].indexCount / 3 << " triangles\n";
+        }
+    }
+
+    // Geometry of one LOD for the render queue (all LODs use the same vertex layout)
+    GLuint vao(int lod) const { return levels[lod].VAO; }
+    GLsizei indexCount(int lod) const { return levels[lod].indexCount; }
+
+private:
+    struct Level {
+        GLuint VAO = 0, VBO = 0, EBO = 0;
+        GLsizei indexCount = 0;
+    };
+
+    static void upload(Level& l, const LodMeshData& data) {
+        glGenVertexArrays(1, &l.VAO);
+        glGenBuffers(1, &l.VBO);
+        glGenBuffers(1, &l.EBO);
+        glBindVertexArray(l.VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, l.VBO);
+        glBufferData(GL_ARRAY_BUFFER, data.vertices.size() * sizeof(LodVertex), data.vertices.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, l.EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, data.indices.size() * sizeof(unsigned int), data.indices.data(), GL_STATIC_DRAW);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(LodVertex), (void*)offsetof(LodVertex, pos));
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(LodVertex), (void*)offsetof(LodVertex, normal));
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(LodVertex), (void*)offsetof(LodVertex, uv));
+        glBindVertexArray(0);
+        l.indexCount = (GLsizei)data.indices.size();
+    }
+
+    static const uint32_t CACHE_MAGIC = 0x31444F4Cu;   // "LOD1"
+
+    // The cache is keyed on the source vertex/index counts so a re-exported asset gets re-cooked.
+    static bool loadCache(const std::string& path, const uint32_t sourceKey[2], std::vector<LodMeshData>& lods) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) return false;
+        uint32_t magic = 0, key[2] = { 0, 0 }, count = 0;
+        in.read((char*)&magic, sizeof(magic));
+        in.read((char*)key, sizeof(key));
+        in.read((char*)&count, sizeof(count));
+        if (!in || magic != CACHE_MAGIC || key[0] != sourceKey[0] || key[1] != sourceKey[1]) return false;
+        if (count == 0 || count > MAX_LODS) return false;
+        lods.resize(count);
+        for (auto& lod : lods) {
+            uint32_t nv = 0, ni = 0;
+            in.read((char*)&nv, sizeof(nv));
+            in.read((char*)&ni, sizeof(ni));
+            if (!in) return false;
+            lod.vertices.resize(nv);
+            lod.indices.resize(ni);
+            in.read((char*)lod.vertices.data(), nv * sizeof(LodVertex));
+            in.read((char*)lod.indices.data(), ni * sizeof(unsigned int));
+        }
+        return (bool)in;
+    }
+
+    static void saveCache(const std::string& path, const uint32_t sourceKey[2], const std::vector<LodMeshData>& lods) {
+        std::ofstream out(path, std::ios::binary);
+        if (!out) {
+            std::cerr << "[LOD] cannot write " << path << ", the LODs are cooked again next start\n";
+            return;
+        }
+        uint32_t magic = CACHE_MAGIC, count = (uint32_t)lods.size();
+        out.write((const char*)&magic, sizeof(magic));
+        out.write((const char*)sourceKey, sizeof(uint32_t) * 2);
+        out.write((const char*)&count, sizeof(count));
+        for (const auto& lod : lods) {
+            uint32_t nv = (uint32_t)lod.vertices.size(), ni = (uint32_t)lod.indices.size();
+            out.write((const char*)&nv, sizeof(nv));
+            out.write((const char*)&ni, sizeof(ni));
+            out.write((const char*)lod.vertices.data(), nv * sizeof(LodVertex));
+            out.write((const char*)lod.indices.data(), ni * sizeof(unsigned int));
+        }
+    }
+
+    Level levels[MAX_LODS];
+};
+
+#endif
@@ -0,0 +1,224 @@
+#ifndef OCCLUSION_BUFFER_H
+#define OCCLUSION_BUFFER_H
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define OCCLUSION_SSE2 1
+#endif
+
+// Small software depth buffer for conservative occlusion culling on the CPU. Both occluders
+// and occludees are boxes whose eye-facing faces are rasterized four pixels at a time (SSE2
+// where available). An occluder only marks the pixels it covers completely, at the farthest
+// depth it reaches inside each pixel; an occludee is visible if any pixel it touches, at the
+// nearest depth it reaches there, is in front of the buffer. Anything uncertain (crossing the
+// near plane, entirely off screen) counts as visible, so the test can only err towards
+// drawing too much. Depth is NDC z/w, which is linear in screen space; smaller is nearer.
+class OcclusionBuffer {
+public:
+    static const int WIDTH = 128;    // multiple of 4
+    static const int HEIGHT = 72;
+
+    void begin(const glm::mat4& viewProj, const glm::vec3& eye) {
+        this->viewProj = viewProj;
+        this->eye = eye;
+        std::fill(depth, depth + WIDTH * HEIGHT, FLT_MAX);
+        occluders = 0;
+    }
+
+    void addOccluder(const glm::vec3& mn, const glm::vec3& mx) {
+        glm::vec3 quads[3][4];
+        int faces = frontFaces(mn, mx, quads);
+        if (faces < 0) return;   // would need clipping; skipping an occluder is always safe
+        occluders++;
+        for (int i = 0; i < faces; ++i) {
+            Face f;
+            if (setupFace(quads[i], true, f)) drawFace(f);
+        }
+    }
+
+    bool visible(const glm::vec3& mn, const glm::vec3& mx) const {
+        if (occluders == 0) return true;
+        glm::vec3 quads[3][4];
+        int faces = frontFaces(mn, mx, quads);
+        if (faces <= 0) return true;   // crosses the near plane or the eye is inside
+        bool onScreen = false;
+        for (int i = 0; i < faces; ++i) {
+            Face f;
+            if (!setupFace(quads[i], false, f)) continue;
+            onScreen = true;
+            if (testFace(f)) return true;
+        }
+        return !onScreen;   // off screen: left to frustum culling
+    }
+
+    int occluderCount() const { return occluders; }
+
+private:
+    static constexpr float NEAR_W = 1e-3f;
+
+    // Edge functions a * x + b * y + c >= 0 inside (the coverage bias is folded into c) and
+    // the depth plane, already moved to the pixel corner the caller asked for.
+    struct Face {
+        float a[4], b[4], c[4];
+        float dzdx, dzdy, zc;
+        int x0, x1, y0, y1;
+    };
+
+    glm::vec3 toScreen(const glm::vec4& c) const {
+        float inv = 1.0f / c.w;
+        return glm::vec3((c.x * inv * 0.5f + 0.5f) * WIDTH, (c.y * inv * 0.5f + 0.5f) * HEIGHT, c.z * inv);
+    }
+
+    // The (at most three) faces of the box the eye is outside of, in screen space; -1 if a
+    // corner is behind the near plane.
+    int frontFaces(const glm::vec3& mn, const glm::vec3& mx, glm::vec3 quads[3][4]) const {
+        glm::vec3 s[8];   // corner i has x from bit 0, y from bit 1, z from bit 2
+        for (int i = 0; i < 8; ++i) {
+            glm::vec4 c = viewProj * glm::vec4((i & 1) ? mx.x : mn.x, (i & 2) ? mx.y : mn.y, (i & 4) ? mx.z : mn.z, 1.0f);
+            if (c.w < NEAR_W) return -1;
+            s[i] = toScreen(c);
+        }
+        int faces = 0;
+        for (int axis = 0; axis < 3; ++axis) {
+            int bit = 1 << axis;
+            int b = 1 << ((axis + 1) % 3), c = 1 << ((axis + 2) % 3);
+            int base;
+            if (eye[axis] < mn[axis]) base = 0;
+            else if (eye[axis] > mx[axis]) base = bit;
+            else continue;
+            quads[faces][0] = s[base];
+            quads[faces][1] = s[base | b];
+            quads[faces][2] = s[base | b | c];
+            quads[faces][3] = s[base | c];
+            faces++;
+        }
+        return faces;
+    }
+
+    // A face is set up as a whole quad (it stays convex in screen space); splitting it into
+    // two triangles would leave an uncovered seam along the diagonal. inner: pixels covered
+    // completely, at their farthest depth; otherwise pixels touched, at their nearest depth.
+    bool setupFace(glm::vec3* v, bool inner, Face& f) const {
+        float area = 0.0f;   // twice the signed area
+        for (int i = 0; i < 4; ++i) area += v[i].x * v[(i + 1) % 4].y - v[(i + 1) % 4].x * v[i].y;
+        if (std::fabs(area) < 1e-6f) return false;
+        if (area < 0.0f) std::swap(v[1], v[3]);
+
+        float minX = FLT_MAX, maxX = -FLT_MAX, minY = FLT_MAX, maxY = -FLT_MAX;
+        for (int i = 0; i < 4; ++i) {
+            minX = std::min(minX, v[i].x); maxX = std::max(maxX, v[i].x);
+            minY = std::min(minY, v[i].y); maxY = std::max(maxY, v[i].y);
+        }
+        f.x0 = std::max(0, (int)std::floor(minX)) & ~3;
+        f.x1 = std::min(WIDTH - 1, (int)std::floor(maxX));
+        f.y0 = std::max(0, (int)std::floor(minY));
+        f.y1 = std::min(HEIGHT - 1, (int)std::floor(maxY));
+        if (f.x0 > f.x1 || f.y0 > f.y1) return false;
+
+        const float side = inner ? 1.0f : -1.0f;
+        for (int i = 0; i < 4; ++i) {
+            const glm::vec3& p = v[i];
+            const glm::vec3& q = v[(i + 1) % 4];
+            f.a[i] = -(q.y - p.y);
+            f.b[i] = q.x - p.x;
+            float bias = 0.5f * (std::fabs(f.a[i]) + std::fabs(f.b[i]));
+            f.c[i] = (q.y - p.y) * p.x - (q.x - p.x) * p.y - side * bias;
+        }
+
+        // depth plane from the larger half of the quad
+        const glm::vec3& v0 = v[0];
+        float areaA = (v[1].x - v0.x) * (v[2].y - v0.y) - (v[2].x - v0.x) * (v[1].y - v0.y);
+        float areaB = (v[2].x - v0.x) * (v[3].y - v0.y) - (v[3].x - v0.x) * (v[2].y - v0.y);
+        const glm::vec3& p1 = areaA >= areaB ? v[1] : v[2];
+        const glm::vec3& p2 = areaA >= areaB ? v[2] : v[3];
+        float tri = std::max(areaA, areaB);
+        f.dzdx = ((p1.z - v0.z) * (p2.y - v0.y) - (p2.z - v0.z) * (p1.y - v0.y)) / tri;
+        f.dzdy = ((p2.z - v0.z) * (p1.x - v0.x) - (p1.z - v0.z) * (p2.x - v0.x)) / tri;
+        f.zc = v0.z - f.dzdx * v0.x - f.dzdy * v0.y + side * 0.5f * (std::fabs(f.dzdx) + std::fabs(f.dzdy));
+        return true;
+    }
+
+#ifdef OCCLUSION_SSE2
+    // lanes of the pixels x .. x + 3 of a row that are inside the face
+    static __m128 insideMask(const Face& f, __m128 px, float py) {
+        const __m128 zero = _mm_setzero_ps();
+        __m128 inside = _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(f.a[0]), px), _mm_set1_ps(f.b[0] * py + f.c[0])), zero);
+        for (int i = 1; i < 4; ++i)
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(f.a[i]), px), _mm_set1_ps(f.b[i] * py + f.c[i])), zero));
+        return inside;
+    }
+
+    void drawFace(const Face& f) {
+        const __m128 lane = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+        for (int y = f.y0; y <= f.y1; ++y) {
+            float py = y + 0.5f;
+            float* row = depth + y * WIDTH;
+            for (int x = f.x0; x <= f.x1; x += 4) {
+                __m128 px = _mm_add_ps(_mm_set1_ps((float)x), lane);
+                __m128 inside = insideMask(f, px, py);
+                if (!_mm_movemask_ps(inside)) continue;
+                __m128 z = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(f.dzdx), px), _mm_set1_ps(f.dzdy * py + f.zc));
+                __m128 old = _mm_load_ps(row + x);
+                __m128 merged = _mm_min_ps(old, z);
+                _mm_store_ps(row + x, _mm_or_ps(_mm_and_ps(inside, merged), _mm_andnot_ps(inside, old)));
+            }
+        }
+    }
+
+    bool testFace(const Face& f) const {
+        const __m128 lane = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+        for (int y = f.y0; y <= f.y1; ++y) {
+            float py = y + 0.5f;
+            const float* row = depth + y * WIDTH;
+            for (int x = f.x0; x <= f.x1; x += 4) {
+                __m128 px = _mm_add_ps(_mm_set1_ps((float)x), lane);
+                __m128 z = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(f.dzdx), px), _mm_set1_ps(f.dzdy * py + f.zc));
+                if (_mm_movemask_ps(_mm_and_ps(insideMask(f, px, py), _mm_cmplt_ps(z, _mm_load_ps(row + x))))) return true;
+            }
+        }
+        return false;
+    }
+#else
+    static bool inside(const Face& f, float px, float py) {
+        for (int i = 0; i < 4; ++i)
+            if (f.a[i] * px + f.b[i] * py + f.c[i] < 0.0f) return false;
+        return true;
+    }
+
+    void drawFace(const Face& f) {
+        for (int y = f.y0; y <= f.y1; ++y) {
+            float py = y + 0.5f;
+            float* row = depth + y * WIDTH;
+            for (int x = f.x0; x <= f.x1; ++x) {
+                float px = x + 0.5f;
+                if (inside(f, px, py)) row[x] = std::min(row[x], f.dzdx * px + f.dzdy * py + f.zc);
+            }
+        }
+    }
+
+    bool testFace(const Face& f) const {
+        for (int y = f.y0; y <= f.y1; ++y) {
+            float py = y + 0.5f;
+            const float* row = depth + y * WIDTH;
+            for (int x = f.x0; x <= f.x1; ++x) {
+                float px = x + 0.5f;
+                if (inside(f, px, py) && f.dzdx * px + f.dzdy * py + f.zc < row[x]) return true;
+            }
+        }
+        return false;
+    }
+#endif
+
+    alignas(16) float depth[WIDTH * HEIGHT];
+    glm::mat4 viewProj{ 1.0f };
+    glm::vec3 eye{ 0.0f };
+    int occluders = 0;
+};
+
+#endif
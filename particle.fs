@@ -0,0 +1,15 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 Corner;
+in vec3 Color;
+
+void main()
+{
+    float r2 = dot(Corner, Corner);
+    if (r2 > 1.0)
+        discard;
+    // additive glow, brightest in the middle
+    float glow = (1.0 - r2) * (1.0 - r2);
+    FragColor = vec4(Color * glow, 1.0);
+}
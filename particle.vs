@@ -0,0 +1,36 @@
+#version 330 core
+
+// one camera-facing quad per particle slot; dead particles collapse to a point off screen
+layout(location = 0) in vec4 posLife;
+layout(location = 1) in vec4 velKind;
+
+layout(std140) uniform FrameData {
+    mat4 projection;
+    mat4 view;
+    vec4 viewPos;
+    vec4 lightPos;
+};
+
+out vec2 Corner;
+out vec3 Color;
+
+void main()
+{
+    if (posLife.w <= 0.0) {
+        gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+        Corner = vec2(0.0);
+        Color = vec3(0.0);
+        return;
+    }
+    bool sparkle = velKind.w < 0.5;
+    Corner = vec2((gl_VertexID & 1) == 0 ? -1.0 : 1.0, (gl_VertexID & 2) == 0 ? -1.0 : 1.0);
+    // fade out over the last quarter second
+    float fade = clamp(posLife.w * 4.0, 0.0, 1.0);
+    Color = (sparkle ? vec3(1.0, 0.8, 0.25) : vec3(1.0, 0.45, 0.12)) * fade;
+
+    float size = sparkle ? 0.07 : 0.05;
+    vec3 camRight = vec3(view[0][0], view[1][0], view[2][0]);
+    vec3 camUp = vec3(view[0][1], view[1][1], view[2][1]);
+    vec3 worldPos = posLife.xyz + (camRight * Corner.x + camUp * Corner.y) * size;
+    gl_Position = projection * view * vec4(worldPos, 1.0);
+}
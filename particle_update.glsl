@@ -0,0 +1,106 @@
+// Particle simulation. ParticleSystem prepends the version line and builds it either as a
+// compute shader that updates the particle buffer in place (COMPUTE defined, GL 4.3) or as a
+// vertex shader whose outputs are captured with transform feedback (GL 3.3).
+
+const int MAX_EMITS = 16;
+
+uniform int emitCount;
+uniform vec4 emitOrigin[MAX_EMITS];   // xyz = position, w = kind
+uniform ivec2 emitRange[MAX_EMITS];   // first slot, slot count (wraps around capacity)
+uniform int capacity;
+uniform float dt;
+uniform int seed;
+
+float random01(uint x)
+{
+    x ^= x >> 16; x *= 0x7feb352du;
+    x ^= x >> 15; x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return float(x) * (1.0 / 4294967296.0);
+}
+
+void spawn(int id, vec4 origin, out vec4 posLife, out vec4 velKind)
+{
+    uint h = uint(id) * 0x9e3779b9u ^ uint(seed) * 0x85ebca6bu;
+    float angle = random01(h) * 6.2831853;
+    float spread = random01(h + 1u);
+    float lift = random01(h + 2u);
+    float span = random01(h + 3u);
+    int kind = int(origin.w + 0.5);
+
+    vec3 vel;
+    float life;
+    if (kind == 0) {
+        // coin pickup: a soft fountain of sparkles
+        vel = vec3(cos(angle) * spread * 1.5, 2.0 + lift * 2.5, sin(angle) * spread * 1.5);
+        life = 0.6 + span * 0.6;
+    }
+    else {
+        // obstacle hit: fast sparks thrown out sideways
+        vel = vec3(cos(angle), 0.3 + lift * 1.2, sin(angle)) * (3.0 + spread * 4.0);
+        life = 0.35 + span * 0.45;
+    }
+    posLife = vec4(origin.xyz, life);
+    velKind = vec4(vel, float(kind));
+}
+
+void simulate(int id, inout vec4 posLife, inout vec4 velKind)
+{
+    for (int i = 0; i < emitCount; ++i) {
+        int rel = (id - emitRange[i].x + capacity) % capacity;
+        if (rel < emitRange[i].y) {
+            spawn(id, emitOrigin[i], posLife, velKind);
+            return;
+        }
+    }
+    if (posLife.w <= 0.0)
+        return;
+    float gravity = velKind.w < 0.5 ? 4.0 : 12.0;
+    velKind.xyz *= exp(-1.5 * dt);
+    velKind.y -= gravity * dt;
+    posLife.xyz += velKind.xyz * dt;
+    // sparks bounce off the floor once they fall back to it
+    if (posLife.y < 0.02 && velKind.y < 0.0) {
+        posLife.y = 0.02;
+        velKind.y *= -0.35;
+    }
+    posLife.w -= dt;
+}
+
+#ifdef COMPUTE
+layout(local_size_x = 64) in;
+
+struct Particle {
+    vec4 posLife;
+    vec4 velKind;
+};
+
+layout(std430, binding = 0) buffer Particles {
+    Particle particles[];
+};
+
+void main()
+{
+    int id = int(gl_GlobalInvocationID.x);
+    if (id >= capacity)
+        return;
+    Particle p = particles[id];
+    simulate(id, p.posLife, p.velKind);
+    particles[id] = p;
+}
+#else
+layout(location = 0) in vec4 posLife;
+layout(location = 1) in vec4 velKind;
+
+out vec4 outPosLife;
+out vec4 outVelKind;
+
+void main()
+{
+    vec4 p = posLife;
+    vec4 v = velKind;
+    simulate(gl_VertexID, p, v);
+    outPosLife = p;
+    outVelKind = v;
+}
+#endif
@@ -0,0 +1,242 @@
+#ifndef PARTICLES_H
+#define PARTICLES_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Matches the Particle struct in particle_update.glsl
+struct Particle {
+    glm::vec4 posLife;   // xyz = position, w = seconds left (dead at <= 0)
+    glm::vec4 velKind;   // xyz = velocity, w = ParticleKind
+};
+
+enum ParticleKind {
+    PARTICLE_SPARKLE = 0,   // coin pickup
+    PARTICLE_IMPACT = 1,    // obstacle hit
+};
+
+// Particles that live entirely on the GPU. The CPU only records emitters (origin, kind,
+// count); each one is given the next run of slots of a ring of CAPACITY particles, and the
+// update shader respawns those slots itself, so bursts never touch particle data on the CPU.
+// Slots are reused oldest first, which with short lifetimes means dead ones. On GL 4.3 a
+// compute shader updates the buffer in place; on GL 3.3 the same code runs as a vertex shader
+// whose output is captured with transform feedback into the other buffer of a pair. Both are
+// built from particle_update.glsl. Nothing runs while no particle can be alive.
+class ParticleSystem {
+public:
+    static const int CAPACITY = 8192;
+    static const int MAX_EMITS = 16;   // per update; matches particle_update.glsl
+    static constexpr float MAX_LIFE = 1.2f;
+
+    static bool computeSupported() {
+        return GLAD_GL_VERSION_4_3 || (GLAD_GL_ARB_compute_shader && GLAD_GL_ARB_shader_storage_buffer_object);
+    }
+
+    void init(const char* updatePath) {
+        std::string source;
+        if (!readFile(updatePath, source)) return;
+        compute = computeSupported();
+        updateProgram = compute ? compileCompute(source) : compileFeedback(source);
+        if (!updateProgram) return;
+
+        std::vector<Particle> zero(CAPACITY, Particle{ glm::vec4(0.0f), glm::vec4(0.0f) });
+        int buffers = compute ? 1 : 2;
+        glGenBuffers(buffers, particleBuffer);
+        glGenVertexArrays(buffers, updateVAO);
+        glGenVertexArrays(buffers, drawVAO);
+        for (int i = 0; i < buffers; ++i) {
+            glBindBuffer(GL_ARRAY_BUFFER, particleBuffer[i]);
+            glBufferData(GL_ARRAY_BUFFER, sizeof(Particle) * CAPACITY, zero.data(), GL_DYNAMIC_COPY);
+            // the update pass reads one particle per vertex, drawing one per instance
+            bindAttributes(updateVAO[i], 0);
+            bindAttributes(drawVAO[i], 1);
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        const char* names[] = { "emitCount", "emitOrigin", "emitRange", "capacity", "dt", "seed" };
+        for (int i = 0; i < UNIFORM_COUNT; ++i) uniforms[i] = glGetUniformLocation(updateProgram, names[i]);
+        idleTime = MAX_LIFE;
+        std::cout << "[Particles] " << CAPACITY << " slots, " << (compute ? "compute" : "transform feedback") << std::endl;
+    }
+
+    bool ready() const { return updateProgram != 0; }
+
+    // Queues a burst for the next update; bursts past MAX_EMITS in one frame are dropped.
+    void emit(const glm::vec3& origin, ParticleKind kind, int count) {
+        if (!ready() || emitCount == MAX_EMITS) return;
+        if (count > CAPACITY) count = CAPACITY;
+        emitOrigin[emitCount] = glm::vec4(origin, (float)kind);
+        emitRange[emitCount * 2] = cursor;
+        emitRange[emitCount * 2 + 1] = count;
+        emitCount++;
+        cursor = (cursor + count) % CAPACITY;
+    }
+
+    // Spawns the queued bursts and advances every particle by dt.
+    void update(float dt) {
+        if (!ready()) return;
+        if (emitCount == 0 && idleTime >= MAX_LIFE) return;
+        idleTime = emitCount > 0 ? 0.0f : idleTime + dt;
+
+        glUseProgram(updateProgram);
+        glUniform1i(uniforms[U_EMIT_COUNT], emitCount);
+        if (emitCount > 0) {
+            glUniform4fv(uniforms[U_EMIT_ORIGIN], emitCount, &emitOrigin[0].x);
+            glUniform2iv(uniforms[U_EMIT_RANGE], emitCount, emitRange);
+        }
+        glUniform1i(uniforms[U_CAPACITY], CAPACITY);
+        glUniform1f(uniforms[U_DT], dt);
+        glUniform1i(uniforms[U_SEED], (int)++frame);
+        emitCount = 0;
+
+        if (compute) {
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, particleBuffer[0]);
+            glDispatchCompute((CAPACITY + 63) / 64, 1, 1);
+            glMemoryBarrier(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+            return;
+        }
+        int next = 1 - current;
+        glEnable(GL_RASTERIZER_DISCARD);
+        glBindVertexArray(updateVAO[current]);
+        glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, particleBuffer[next]);
+        glBeginTransformFeedback(GL_POINTS);
+        glDrawArrays(GL_POINTS, 0, CAPACITY);
+        glEndTransformFeedback();
+        glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+        glBindVertexArray(0);
+        glDisable(GL_RASTERIZER_DISCARD);
+        current = next;
+    }
+
+    // false once every particle has died
+    bool active() const { return ready() && idleTime < MAX_LIFE; }
+
+    // Additive camera-facing quads, one instance per slot (dead ones collapse in the shader).
+    void draw(GLuint program) const {
+        glUseProgram(program);
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_ONE, GL_ONE);
+        glDepthMask(GL_FALSE);
+        glBindVertexArray(drawVAO[current]);
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, CAPACITY);
+        glBindVertexArray(0);
+        glDepthMask(GL_TRUE);
+        glDisable(GL_BLEND);
+    }
+
+    // Kills every particle (a new run starts).
+    void clear() {
+        if (!ready()) return;
+        std::vector<Particle> zero(CAPACITY, Particle{ glm::vec4(0.0f), glm::vec4(0.0f) });
+        for (int i = 0; i < (compute ? 1 : 2); ++i) {
+            glBindBuffer(GL_ARRAY_BUFFER, particleBuffer[i]);
+            glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(Particle) * CAPACITY, zero.data());
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        emitCount = 0;
+        idleTime = MAX_LIFE;
+    }
+
+private:
+    enum Uniform { U_EMIT_COUNT, U_EMIT_ORIGIN, U_EMIT_RANGE, U_CAPACITY, U_DT, U_SEED, UNIFORM_COUNT };
+
+    void bindAttributes(GLuint vao, GLuint divisor) {
+        glBindVertexArray(vao);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(Particle), (void*)offsetof(Particle, posLife));
+        glVertexAttribDivisor(0, divisor);
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(Particle), (void*)offsetof(Particle, velKind));
+        glVertexAttribDivisor(1, divisor);
+        glBindVertexArray(0);
+    }
+
+    static bool readFile(const char* path, std::string& out) {
+        std::ifstream file(path);
+        if (!file) {
+            std::cerr << "[Particles] missing " << path << ", particles disabled\n";
+            return false;
+        }
+        std::stringstream ss;
+        ss << file.rdbuf();
+        out = ss.str();
+        return true;
+    }
+
+    static GLuint compileStage(GLenum type, const std::string& source) {
+        const char* src = source.c_str();
+        GLuint shader = glCreateShader(type);
+        glShaderSource(shader, 1, &src, nullptr);
+        glCompileShader(shader);
+        GLint ok = 0;
+        glGetShaderiv(shader, GL_COMPILE_STATUS, &ok);
+        if (!ok) {
+            char log[1024];
+            glGetShaderInfoLog(shader, sizeof(log), nullptr, log);
+            std::cerr << "[Particles] compile error:\n" << log << std::endl;
+            glDeleteShader(shader);
+            return 0;
+        }
+        return shader;
+    }
+
+    static GLuint link(GLuint program) {
+        glLinkProgram(program);
+        GLint ok = 0;
+        glGetProgramiv(program, GL_LINK_STATUS, &ok);
+        if (!ok) {
+            char log[1024];
+            glGetProgramInfoLog(program, sizeof(log), nullptr, log);
+            std::cerr << "[Particles] link error:\n" << log << std::endl;
+            glDeleteProgram(program);
+            return 0;
+        }
+        return program;
+    }
+
+    static GLuint compileCompute(const std::string& source) {
+        GLuint cs = compileStage(GL_COMPUTE_SHADER, "#version 430 core\n#define COMPUTE\n" + source);
+        if (!cs) return 0;
+        GLuint program = glCreateProgram();
+        glAttachShader(program, cs);
+        glDeleteShader(cs);
+        return link(program);
+    }
+
+    // The captured outputs have to be named before linking, so this program cannot come from
+    // the shader cache.
+    static GLuint compileFeedback(const std::string& source) {
+        GLuint vs = compileStage(GL_VERTEX_SHADER, "#version 330 core\n" + source);
+        if (!vs) return 0;
+        GLuint program = glCreateProgram();
+        glAttachShader(program, vs);
+        glDeleteShader(vs);
+        const char* varyings[] = { "outPosLife", "outVelKind" };
+        glTransformFeedbackVaryings(program, 2, varyings, GL_INTERLEAVED_ATTRIBS);
+        return link(program);
+    }
+
+    GLuint updateProgram = 0;
+    bool compute = false;
+    GLuint particleBuffer[2] = { 0, 0 };
+    GLuint updateVAO[2] = { 0, 0 };
+    GLuint drawVAO[2] = { 0, 0 };
+    int current = 0;   // buffer holding the latest state
+    GLint uniforms[UNIFORM_COUNT] = {};
+
+    glm::vec4 emitOrigin[MAX_EMITS];
+    GLint emitRange[MAX_EMITS * 2] = {};   // first slot, slot count
+    int emitCount = 0;
+    int cursor = 0;
+    unsigned int frame = 0;
+    float idleTime = 0.0f;   // simulated time since the last burst
+};
+
+#endif
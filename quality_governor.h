@@ -0,0 +1,185 @@
+#ifndef QUALITY_GOVERNOR_H
+#define QUALITY_GOVERNOR_H
+
+#include <glad/glad.h>
+
+#include <algorithm>
+
+// GPU time of one frame from GL_TIME_ELAPSED queries. Results are read LATENCY frames late
+// from a ring of query objects, so measuring never waits on the GPU.
+class GpuFrameTimer {
+public:
+    static const int LATENCY = 4;
+
+    void init() {
+        glGenQueries(LATENCY, queries);
+        for (int i = 0; i < LATENCY; ++i) pending[i] = false;
+    }
+
+    void begin() {
+        if (!queries[0] || pending[cursor]) return;   // slot still in flight: skip this frame
+        glBeginQuery(GL_TIME_ELAPSED, queries[cursor]);
+        open = true;
+    }
+
+    void end() {
+        if (open) {
+            glEndQuery(GL_TIME_ELAPSED);
+            pending[cursor] = true;
+            open = false;
+        }
+        cursor = (cursor + 1) % LATENCY;
+
+        // collect whatever has finished since the last frame
+        for (int i = 0; i < LATENCY; ++i) {
+            if (!pending[i]) continue;
+            GLint ready = 0;
+            glGetQueryObjectiv(queries[i], GL_QUERY_RESULT_AVAILABLE, &ready);
+            if (!ready) continue;
+            GLuint64 ns = 0;
+            glGetQueryObjectui64v(queries[i], GL_QUERY_RESULT, &ns);
+            lastMs = (float)((double)ns * 1e-6);
+            pending[i] = false;
+        }
+    }
+
+    // most recent finished measurement, 0 until the first one arrives
+    float milliseconds() const { return lastMs; }
+
+private:
+    GLuint queries[LATENCY] = { 0, 0, 0, 0 };
+    bool pending[LATENCY] = { false, false, false, false };
+    int cursor = 0;
+    bool open = false;
+    float lastMs = 0.0f;
+};
+
+struct QualitySettings {
+    float renderScale = 1.0f;     // scene resolution relative to the output
+    float coinLodBias = 1.0f;     // > 1 switches coins to coarser LODs / impostors earlier
+    int drawBlocks = 50;          // blocks ahead of the player that are rendered
+    int shadowResolution = 1024;  // per cascade
+};
+
+// Holds the frame time under budget by trading quality. Two ladders are walked separately:
+// GPU-bound frames lower render scale and shadow resolution, CPU-bound frames lower the
+// draw distance and push coins to cheaper LODs. A step down needs the smoothed time over
+// budget for a short while; a step up needs a long calm stretch, and that stretch doubles
+// every time a step up has to be undone, so the governor settles instead of oscillating.
+class QualityGovernor {
+public:
+    float budgetMs = 1000.0f / 60.0f;
+    float overBudget = 1.1f;     // step down above budget * overBudget ...
+    float underBudget = 0.8f;    // ... step up below budget * underBudget
+    float downDelay = 0.5f;      // seconds over budget before stepping down
+    float baseUpDelay = 3.0f;    // seconds under budget before stepping up
+    float maxUpDelay = 30.0f;
+    bool enabled = false;
+
+    struct GpuTier { float renderScale; int shadowResolution; };
+    struct CpuTier { float coinLodBias; float drawFraction; };
+
+    void init(const QualitySettings& best) {
+        gpuTiers[0] = { best.renderScale, best.shadowResolution };
+        cpuTiers[0].coinLodBias = best.coinLodBias;
+        fullDrawBlocks = best.drawBlocks;
+        reset();
+    }
+
+    // Back to the best settings, e.g. when the governor is switched off.
+    void reset() {
+        gpuLevel = cpuLevel = 0;
+        overTime = underTime = sinceRaise = 0.0f;
+        upDelay = baseUpDelay;
+        smoothCpu = smoothGpu = 0.0f;
+        lastRaise = Side::None;
+        apply();
+    }
+
+    // Feeds one frame's CPU work time (without the swap) and the latest GPU time.
+    // Returns true when settings() changed.
+    bool update(float cpuMs, float gpuMs, float dt) {
+        if (!enabled) return false;
+        smoothCpu = smoothCpu <= 0.0f ? cpuMs : smoothCpu + (cpuMs - smoothCpu) * 0.1f;
+        smoothGpu = smoothGpu <= 0.0f ? gpuMs : smoothGpu + (gpuMs - smoothGpu) * 0.1f;
+        float worst = std::max(smoothCpu, smoothGpu);
+        sinceRaise += dt;
+
+        if (worst > budgetMs * overBudget) {
+            underTime = 0.0f;
+            overTime += dt;
+            if (overTime < downDelay) return false;
+            overTime = 0.0f;
+
+            // undoing a recent raise means the raise was premature: wait longer next time
+            if (lastRaise != Side::None && sinceRaise < 2.0f) {
+                upDelay = std::min(upDelay * 2.0f, maxUpDelay);
+                lastRaise = Side::None;
+            }
+            bool gpuBound = smoothGpu >= smoothCpu;
+            if (gpuBound && gpuLevel + 1 < GPU_TIERS) return step(Side::Gpu, +1);
+            if (!gpuBound && cpuLevel + 1 < CPU_TIERS) return step(Side::Cpu, +1);
+            // the bottleneck side is exhausted: the other one still helps a little
+            if (gpuLevel + 1 < GPU_TIERS) return step(Side::Gpu, +1);
+            if (cpuLevel + 1 < CPU_TIERS) return step(Side::Cpu, +1);
+            return false;
+        }
+
+        overTime = 0.0f;
+        if (worst < budgetMs * underBudget && (gpuLevel > 0 || cpuLevel > 0)) {
+            underTime += dt;
+            if (underTime < upDelay) return false;
+            underTime = 0.0f;
+            sinceRaise = 0.0f;
+            // resolution is the most visible loss, so it comes back first
+            if (gpuLevel > 0) return step(Side::Gpu, -1);
+            return step(Side::Cpu, -1);
+        }
+        underTime = 0.0f;
+        return false;
+    }
+
+    const QualitySettings& settings() const { return current; }
+    int gpuTier() const { return gpuLevel; }
+    int cpuTier() const { return cpuLevel; }
+
+private:
+    enum class Side { None, Gpu, Cpu };
+    static const int GPU_TIERS = 7;
+    static const int CPU_TIERS = 5;
+
+    // Decisions are not printed from here, inside the frame loop; the game records them in its
+    // run log with gpuTier(), cpuTier() and the resulting settings().
+    bool step(Side side, int dir) {
+        if (side == Side::Gpu) gpuLevel += dir;
+        else cpuLevel += dir;
+        lastRaise = dir < 0 ? side : Side::None;
+        apply();
+        return true;
+    }
+
+    void apply() {
+        current.renderScale = gpuTiers[gpuLevel].renderScale;
+        current.shadowResolution = gpuTiers[gpuLevel].shadowResolution;
+        current.coinLodBias = cpuTiers[cpuLevel].coinLodBias;
+        current.drawBlocks = std::max(1, (int)(fullDrawBlocks * cpuTiers[cpuLevel].drawFraction + 0.5f));
+    }
+
+    // tier 0 is replaced by the settings passed to init()
+    GpuTier gpuTiers[GPU_TIERS] = {
+        { 1.0f, 1024 }, { 0.9f, 1024 }, { 0.8f, 1024 }, { 0.8f, 512 }, { 0.7f, 512 }, { 0.6f, 512 }, { 0.5f, 512 },
+    };
+    CpuTier cpuTiers[CPU_TIERS] = {
+        { 1.0f, 1.0f }, { 1.5f, 0.9f }, { 2.0f, 0.8f }, { 3.0f, 0.65f }, { 4.0f, 0.5f },
+    };
+
+    QualitySettings current;
+    int fullDrawBlocks = 50;
+    int gpuLevel = 0, cpuLevel = 0;
+    float smoothCpu = 0.0f, smoothGpu = 0.0f;
+    float overTime = 0.0f, underTime = 0.0f, sinceRaise = 0.0f;
+    float upDelay = 3.0f;
+    Side lastRaise = Side::None;
+};
+
+#endif
@@ -0,0 +1,84 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// Render queue: draw items are collected for the whole frame, sorted by a 64-bit key and
+// then submitted in one go so shader/texture/VAO binds only happen when they change.
+// This header has no GL dependency; submission lives with the renderer.
+//
+// Key layout, most significant first:
+//   pass (4) | program (10) | texture (12) | vao (12) | depth (26)
+// Opaque items carry front-to-back depth in the low bits; within a pass state wins over depth.
+enum class RenderPass : uint8_t {
+    Opaque = 0,
+    Sky = 1,
+    Transparent = 2,   // blended, drawn last without depth writes
+};
+
+struct RenderItem;
+typedef void (*RenderCustomFn)(const RenderItem& item);
+
+struct RenderItem {
+    uint64_t key = 0;
+    RenderPass pass = RenderPass::Opaque;
+    unsigned int program = 0;
+    unsigned int texture = 0;
+    unsigned int vao = 0;
+    int indexCount = 0;
+    long long objectOffset = -1;   // ObjectData range in the stream buffer, -1 for none
+    long long objectSize = 0;
+    RenderCustomFn custom = nullptr;  // items that issue their own GL calls (batches, sky)
+};
+
+struct RenderStats {
+    int items = 0;
+    int drawCalls = 0;
+    int programBinds = 0;
+    int textureBinds = 0;
+    int vaoBinds = 0;
+    int objectBinds = 0;
+    int prepassDraws = 0;
+};
+
+inline uint64_t MakeRenderKey(RenderPass pass, unsigned int program, unsigned int texture, unsigned int vao, float depth01) {
+    if (depth01 < 0.0f) depth01 = 0.0f;
+    if (depth01 > 1.0f) depth01 = 1.0f;
+    uint64_t depth = (uint64_t)(depth01 * (float)((1u << 26) - 1));
+    return ((uint64_t)pass & 0xF) << 60 |
+        ((uint64_t)program & 0x3FF) << 50 |
+        ((uint64_t)texture & 0xFFF) << 38 |
+        ((uint64_t)vao & 0xFFF) << 26 |
+        depth;
+}
+
+class RenderQueue {
+public:
+    bool depthPrepass = false;
+    float farPlane = 600.0f;
+
+    void clear() { items.clear(); }
+
+    // depth is the view distance, normalized against farPlane for the key
+    void push(RenderItem item, float depth) {
+        item.key = MakeRenderKey(item.pass, item.program, item.texture, item.vao, depth / farPlane);
+        items.push_back(item);
+    }
+
+    void sort() {
+        std::sort(items.begin(), items.end(),
+            [](const RenderItem& a, const RenderItem& b) { return a.key < b.key; });
+    }
+
+    const std::vector<RenderItem>& list() const { return items; }
+    size_t size() const { return items.size(); }
+
+    RenderStats stats;
+
+private:
+    std::vector<RenderItem> items;
+};
+
+#endif
@@ -0,0 +1,101 @@
+#ifndef RENDER_TARGET_H
+#define RENDER_TARGET_H
+
+#include <glad/glad.h>
+
+#include <stb_image_write.h>
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Where a frame is rendered: the window's default framebuffer or an offscreen FBO
+// (RGBA8 color + 24-bit depth renderbuffers). Offscreen targets let the game run on a
+// headless context (OSMesa / EGL surfaceless, e.g. Mesa llvmpipe) and read frames back.
+class RenderTarget {
+public:
+    void initWindow(int w, int h) {
+        fbo = 0;
+        width = w;
+        height = h;
+    }
+
+    bool initOffscreen(int w, int h) {
+        glGenFramebuffers(1, &fbo);
+        glGenRenderbuffers(1, &colorRB);
+        glGenRenderbuffers(1, &depthRB);
+        allocate(w, h);
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorRB);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthRB);
+        bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        if (!complete) std::cerr << "[RenderTarget] offscreen framebuffer incomplete\n";
+        return complete;
+    }
+
+    void resize(int w, int h) {
+        if (w <= 0 || h <= 0) return;   // minimized
+        if (fbo) allocate(w, h);
+        width = w;
+        height = h;
+    }
+
+    void bind() const {
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glViewport(0, 0, width, height);
+    }
+
+    // Reads the current frame as tightly packed RGBA8 rows, top row first.
+    void readPixels(std::vector<unsigned char>& rgba) const {
+        rgba.resize((size_t)width * height * 4);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+        if (!fbo) glReadBuffer(GL_BACK);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, rgba.data());
+        glPixelStorei(GL_PACK_ALIGNMENT, 4);
+
+        // GL rows start at the bottom
+        size_t stride = (size_t)width * 4;
+        std::vector<unsigned char> row(stride);
+        for (int y = 0; y < height / 2; ++y) {
+            unsigned char* a = rgba.data() + stride * y;
+            unsigned char* b = rgba.data() + stride * (height - 1 - y);
+            std::copy(a, a + stride, row.data());
+            std::copy(b, b + stride, a);
+            std::copy(row.data(), row.data() + stride, b);
+        }
+    }
+
+    bool savePNG(const std::string& path) const {
+        std::vector<unsigned char> rgba;
+        readPixels(rgba);
+        if (!stbi_write_png(path.c_str(), width, height, 4, rgba.data(), width * 4)) {
+            std::cerr << "[RenderTarget] failed to write " << path << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    bool isOffscreen() const { return fbo != 0; }
+    GLuint framebuffer() const { return fbo; }
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+
+private:
+    void allocate(int w, int h) {
+        glBindRenderbuffer(GL_RENDERBUFFER, colorRB);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, w, h);
+        glBindRenderbuffer(GL_RENDERBUFFER, depthRB);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, w, h);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+        width = w;
+        height = h;
+    }
+
+    GLuint fbo = 0, colorRB = 0, depthRB = 0;
+    int width = 0, height = 0;
+};
+
+#endif
@@ -0,0 +1,278 @@
+#ifndef RUN_LOG_H
+#define RUN_LOG_H
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+enum class RunLogType : uint16_t {
+    RunStart = 1,    // a = level seed
+    Coin = 2,        // a, b, c = pickup position
+    Hit = 3,         // a, b, c = impact point
+    Speed = 4,       // a = speed multiplier, b = block reached, c = coins
+    FrameTime = 5,   // a = CPU ms, b = GPU ms, c = wall-clock ms since the last frame
+    RunEnd = 6,      // a = coins, b = block reached; time = length of the run
+    Quality = 7,     // a = GPU tier, b = CPU tier, c = shadow map resolution after the governor's step
+    RenderScale = 8, // a = render scale, b, c = scene width and height
+};
+
+enum RunLogFlags : uint16_t {
+    RUN_LOG_REPLAY = 1u << 0,       // driven by a recording
+    RUN_LOG_FIXED_STEP = 1u << 1,   // headless or benchmark run at fixed steps
+    RUN_LOG_ABANDONED = 1u << 2,    // RunEnd: the game was closed before the run ended
+};
+
+struct RunLogRecord {
+    uint16_t type;    // RunLogType
+    uint16_t flags;   // RunLogFlags
+    uint32_t run;     // run number within the log, from 1
+    float time;       // seconds into the run (World::time)
+    float a, b, c;
+};
+static_assert(sizeof(RunLogRecord) == 24, "run log records are written as raw bytes");
+
+// The first HEADER_SIZE bytes of a log; records follow
+struct RunLogHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t recordSize;
+    uint32_t runs;        // runs started
+    uint64_t count;       // records written; readers stop here, whatever the file size
+    uint64_t capacity;    // records the file has room for
+    int32_t bestCoins;    // high scores over the finished runs
+    int32_t bestBlock;
+    float bestTime;
+};
+
+// Append-only binary log of every run: starts and ends, coin pickups, obstacle hits, speed
+// samples and frame times, kept across sessions in one file (tools/run_stats.cpp reads it).
+// The file is memory-mapped, so appending is a store into the mapping and a bump of the
+// header's count: no allocation, no system call, and records written before a crash are
+// still in the page cache. Growing the file happens only in beginRun, which leaves at least
+// RESERVE records of room; a run that outgrows it drops records (counted) rather than block.
+// Unused room is cut off again on close. One thread writes.
+class RunLog {
+public:
+    static const uint32_t MAGIC = 0x474C5254u;   // "TRLG"
+    static const uint32_t VERSION = 1;
+    static const size_t HEADER_SIZE = 64;
+    static const uint64_t RESERVE = 1u << 18;   // 6 MB, about half an hour at 144 fps
+
+    ~RunLog() { close(); }
+
+    bool open(const std::string& logPath) {
+        close();
+        path = logPath;
+#ifdef _WIN32
+        file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, OPEN_ALWAYS,
+                           FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) return fail("cannot open");
+        LARGE_INTEGER size;
+        GetFileSizeEx(file, &size);
+        uint64_t bytes = (uint64_t)size.QuadPart;
+#else
+        fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+        if (fd < 0) return fail("cannot open");
+        struct stat st;
+        fstat(fd, &st);
+        uint64_t bytes = (uint64_t)st.st_size;
+#endif
+        if (bytes == 0) {
+            if (!map(HEADER_SIZE + RESERVE * sizeof(RunLogRecord))) return fail("cannot map");
+            std::memset(header, 0, HEADER_SIZE);
+            header->magic = MAGIC;
+            header->version = VERSION;
+            header->recordSize = sizeof(RunLogRecord);
+            header->capacity = RESERVE;
+        }
+        else {
+            RunLogHeader existing;
+            if (bytes < HEADER_SIZE || !readHeader(existing) || existing.magic != MAGIC ||
+                existing.recordSize != sizeof(RunLogRecord) || existing.count > (bytes - HEADER_SIZE) / sizeof(RunLogRecord))
+                return fail("is not a run log, not logging");
+            if (existing.version != VERSION) return fail("was written by another log version, not logging");
+            // a crash leaves the reserved room behind; count says how much of it is used
+            if (!map(bytes)) return fail("cannot map");
+        }
+        std::cout << "[RunLog] " << path << ": " << header->runs << " runs, " << header->count << " records";
+        if (header->bestCoins > 0) std::cout << ", best " << header->bestCoins << " coins";
+        std::cout << std::endl;
+        return true;
+    }
+
+    bool isOpen() const { return header != nullptr; }
+
+    // Starts a run; also the one place the file grows.
+    void beginRun(float seed, uint16_t runFlags) {
+        if (!header) return;
+        if (header->capacity - header->count < RESERVE &&
+            !map(HEADER_SIZE + (header->count + RESERVE) * sizeof(RunLogRecord))) {
+            std::cerr << "[RunLog] cannot grow " << path << ", not logging\n";
+            return;
+        }
+        header->runs++;
+        flags = runFlags;
+        inRun = true;
+        append(RunLogType::RunStart, 0.0f, seed);
+    }
+
+    // Hot path: never allocates or blocks; drops the record when the reserved room is used up.
+    // The last slot is kept for RunEnd, so a run that fills the log still has its result.
+    void append(RunLogType type, float time, float a = 0.0f, float b = 0.0f, float c = 0.0f) {
+        if (!header || !inRun) return;
+        if (header->count + (type == RunLogType::RunEnd ? 0 : 1) >= header->capacity) {
+            dropped++;
+            return;
+        }
+        RunLogRecord& r = records[header->count];
+        r.type = (uint16_t)type;
+        r.flags = flags;
+        r.run = header->runs;
+        r.time = time;
+        r.a = a;
+        r.b = b;
+        r.c = c;
+        header->count++;   // after the record, so a reader never sees a half-written one
+    }
+
+    // Closes the run. Finished live runs count toward the high scores; abandoned ones, replays
+    // and fixed-step runs do not.
+    void endRun(float time, int coins, int block, bool abandoned) {
+        if (!header || !inRun) return;
+        if (abandoned) flags |= RUN_LOG_ABANDONED;
+        append(RunLogType::RunEnd, time, (float)coins, (float)block);
+        inRun = false;
+        if (abandoned || (flags & (RUN_LOG_REPLAY | RUN_LOG_FIXED_STEP))) return;
+        if (coins > header->bestCoins) header->bestCoins = coins;
+        if (block > header->bestBlock) header->bestBlock = block;
+        if (time > header->bestTime) header->bestTime = time;
+    }
+
+    bool running() const { return inRun; }
+    int bestCoins() const { return header ? header->bestCoins : 0; }
+
+    void close() {
+        if (!header && !hasFile()) return;
+        if (header) {
+            uint64_t used = HEADER_SIZE + header->count * sizeof(RunLogRecord);
+            header->capacity = header->count;
+            if (dropped > 0) std::cout << "[RunLog] " << dropped << " records dropped (log full)" << std::endl;
+            unmap();
+            resize(used);
+        }
+#ifdef _WIN32
+        CloseHandle(file);
+        file = INVALID_HANDLE_VALUE;
+#else
+        ::close(fd);
+        fd = -1;
+#endif
+        inRun = false;
+    }
+
+private:
+    bool fail(const char* what) {
+        std::cerr << "[RunLog] " << path << " " << what << "\n";
+        unmap();
+#ifdef _WIN32
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+        file = INVALID_HANDLE_VALUE;
+#else
+        if (fd >= 0) ::close(fd);
+        fd = -1;
+#endif
+        return false;
+    }
+
+    bool hasFile() const {
+#ifdef _WIN32
+        return file != INVALID_HANDLE_VALUE;
+#else
+        return fd >= 0;
+#endif
+    }
+
+    bool readHeader(RunLogHeader& out) {
+#ifdef _WIN32
+        DWORD got = 0;
+        SetFilePointer(file, 0, nullptr, FILE_BEGIN);
+        return ReadFile(file, &out, sizeof(out), &got, nullptr) && got == sizeof(out);
+#else
+        return pread(fd, &out, sizeof(out), 0) == (ssize_t)sizeof(out);
+#endif
+    }
+
+    bool resize(uint64_t bytes) {
+#ifdef _WIN32
+        LARGE_INTEGER size;
+        size.QuadPart = (LONGLONG)bytes;
+        return SetFilePointerEx(file, size, nullptr, FILE_BEGIN) && SetEndOfFile(file);
+#else
+        return ftruncate(fd, (off_t)bytes) == 0;
+#endif
+    }
+
+    // (Re)maps the whole file at the given size, growing it first; on failure logging stops.
+    bool map(uint64_t bytes) {
+        unmap();
+        if (!resize(bytes)) return false;
+#ifdef _WIN32
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE, 0, 0, nullptr);
+        void* base = mapping ? MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, 0) : nullptr;
+#else
+        void* base = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (base == MAP_FAILED) base = nullptr;
+#endif
+        if (!base) return false;
+        mappedBytes = bytes;
+        header = (RunLogHeader*)base;
+        records = (RunLogRecord*)((char*)base + HEADER_SIZE);
+        if (header->magic == MAGIC) header->capacity = (bytes - HEADER_SIZE) / sizeof(RunLogRecord);
+        return true;
+    }
+
+    void unmap() {
+        if (!header) return;
+#ifdef _WIN32
+        UnmapViewOfFile(header);
+        CloseHandle(mapping);
+        mapping = nullptr;
+#else
+        munmap(header, mappedBytes);
+#endif
+        header = nullptr;
+        records = nullptr;
+        mappedBytes = 0;
+    }
+
+    std::string path;
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#else
+    int fd = -1;
+#endif
+    RunLogHeader* header = nullptr;
+    RunLogRecord* records = nullptr;
+    uint64_t mappedBytes = 0;
+    uint64_t dropped = 0;
+    uint16_t flags = 0;
+    bool inRun = false;
+};
+
+static_assert(sizeof(RunLogHeader) <= RunLog::HEADER_SIZE, "header must fit in front of the records");
+
+#endif
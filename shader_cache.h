@@ -0,0 +1,311 @@
+#ifndef SHADER_CACHE_H
+#define SHADER_CACHE_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <direct.h>
+#endif
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// A linked vertex + fragment program with the uniform setters the game uses. ID changes when
+// the program is hot-reloaded, so read it when drawing instead of keeping a copy.
+class ShaderProgram {
+public:
+    unsigned int ID = 0;
+
+    void use() const { glUseProgram(ID); }
+    void setBool(const char* name, bool value) const { glUniform1i(glGetUniformLocation(ID, name), (int)value); }
+    void setInt(const char* name, int value) const { glUniform1i(glGetUniformLocation(ID, name), value); }
+    void setFloat(const char* name, float value) const { glUniform1f(glGetUniformLocation(ID, name), value); }
+    void setVec3(const char* name, const glm::vec3& value) const { glUniform3fv(glGetUniformLocation(ID, name), 1, glm::value_ptr(value)); }
+    void setVec4(const char* name, const glm::vec4& value) const { glUniform4fv(glGetUniformLocation(ID, name), 1, glm::value_ptr(value)); }
+    void setMat4(const char* name, const glm::mat4& value) const { glUniformMatrix4fv(glGetUniformLocation(ID, name), 1, GL_FALSE, glm::value_ptr(value)); }
+
+private:
+    friend class ShaderCache;
+    std::string vertexPath, fragmentPath;
+    std::function<void(ShaderProgram&)> setup;   // sampler units, uniform blocks, constant uniforms
+    long long vertexStamp = 0, fragmentStamp = 0;
+    std::vector<std::string> includePaths;       // files spliced in by #include, with their stamps
+    std::vector<long long> includeStamps;
+};
+
+// Builds every shader program of the game. Linked programs are saved with glGetProgramBinary
+// under a key hashed from both sources and the driver (vendor, renderer, version), so the next
+// start loads them instead of compiling; a changed shader or driver simply misses the cache.
+// A line #include "file" is replaced by that file (relative to the shader, not nested), so the
+// lit shaders share lighting.glsl; the key hashes the spliced source, includes and all.
+// With watching on, poll() checks the source files' modification times twice a second and
+// rebuilds only the programs whose files changed. A program that fails to rebuild keeps
+// running its last good version.
+class ShaderCache {
+public:
+    void init(const std::string& directory) {
+        cacheDir = directory;
+        GLint formats = 0;
+        if (GLAD_GL_VERSION_4_1 || GLAD_GL_ARB_get_program_binary)
+            glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        binaries = formats > 0 && !cacheDir.empty();
+        if (binaries) makeDirectory(cacheDir);
+
+        std::string driver;
+        const GLenum strings[] = { GL_VENDOR, GL_RENDERER, GL_VERSION };
+        for (GLenum e : strings) {
+            const char* s = (const char*)glGetString(e);
+            driver += s ? s : "";
+            driver += '\n';
+        }
+        driverHash = hash(driver, FNV_OFFSET);
+        if (!binaries) std::cout << "[Shaders] program binaries unavailable, compiling from source" << std::endl;
+    }
+
+    bool watching = false;
+
+    // The returned program stays at the same address for the cache's lifetime. If it neither
+    // loads nor compiles its ID is 0 (errors are logged) and a hot reload can still fix it.
+    // setup runs after every (re)link with the program bound.
+    ShaderProgram* load(const char* vertexPath, const char* fragmentPath,
+                        std::function<void(ShaderProgram&)> setup = nullptr) {
+        std::unique_ptr<ShaderProgram> program(new ShaderProgram());
+        program->vertexPath = vertexPath;
+        program->fragmentPath = fragmentPath;
+        program->setup = std::move(setup);
+        auto start = std::chrono::steady_clock::now();
+        build(*program);
+        loadMs += std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+        programs.push_back(std::move(program));
+        return programs.back().get();
+    }
+
+    // Hot reload; returns the number of programs rebuilt.
+    int poll() {
+        if (!watching) return 0;
+        auto now = std::chrono::steady_clock::now();
+        if (now - lastPoll < std::chrono::milliseconds(500)) return 0;
+        lastPoll = now;
+
+        int rebuilt = 0;
+        for (auto& p : programs) {
+            long long vs = stamp(p->vertexPath), fs = stamp(p->fragmentPath);
+            bool includeChanged = false;
+            for (size_t i = 0; i < p->includePaths.size(); ++i)
+                includeChanged |= stamp(p->includePaths[i]) != p->includeStamps[i];
+            if (vs == p->vertexStamp && fs == p->fragmentStamp && !includeChanged) continue;
+            std::cout << "[Shaders] reloading " << p->vertexPath << " + " << p->fragmentPath << std::endl;
+            if (build(*p)) rebuilt++;
+        }
+        return rebuilt;
+    }
+
+    void report() const {
+        std::cout << "[Shaders] " << programs.size() << " programs in " << loadMs << " ms ("
+            << fromCache << " from cache, " << compiled << " compiled)" << std::endl;
+    }
+
+private:
+    static const uint64_t FNV_OFFSET = 14695981039346656037ull;
+    static const uint32_t BINARY_MAGIC = 0x42505254;   // "TRPB"
+
+    static uint64_t hash(const std::string& data, uint64_t h) {
+        for (unsigned char c : data) {
+            h ^= c;
+            h *= 1099511628211ull;
+        }
+        return h;
+    }
+
+    static long long stamp(const std::string& path) {
+        struct stat st;
+        if (stat(path.c_str(), &st) != 0) return 0;
+        return (long long)st.st_mtime * 1000003ll + (long long)st.st_size;
+    }
+
+    static void makeDirectory(const std::string& path) {
+#ifdef _WIN32
+        _mkdir(path.c_str());
+#else
+        mkdir(path.c_str(), 0755);
+#endif
+    }
+
+    static bool readFile(const std::string& path, std::string& out) {
+        std::ifstream file(path);
+        if (!file) {
+            std::cerr << "[Shaders] cannot read " << path << "\n";
+            return false;
+        }
+        std::stringstream ss;
+        ss << file.rdbuf();
+        out = ss.str();
+        return true;
+    }
+
+    // Reads a shader and splices in the files named by its #include lines. Errors in an
+    // included file are reported as source string 1; the #line after it puts the rest back on
+    // the shader's own line numbers (GLSL 3.30+ gives the line after the directive that number).
+    static bool readSource(const std::string& path, std::string& out, std::vector<std::string>& includes) {
+        std::string text;
+        if (!readFile(path, text)) return false;
+        std::string dir = path.substr(0, path.find_last_of("/\\") + 1);
+        std::istringstream lines(text);
+        std::string line;
+        int lineNo = 0;
+        out.clear();
+        while (std::getline(lines, line)) {
+            lineNo++;
+            size_t open = line.find('"'), close = open == std::string::npos ? open : line.find('"', open + 1);
+            if (line.compare(0, 8, "#include") != 0 || close == std::string::npos) {
+                out += line;
+                out += '\n';
+                continue;
+            }
+            std::string includePath = dir + line.substr(open + 1, close - open - 1);
+            includes.push_back(includePath);
+            std::string body;
+            if (!readFile(includePath, body)) return false;
+            out += "#line 1 1\n";
+            out += body;
+            out += "\n#line " + std::to_string(lineNo + 1) + " 0\n";
+        }
+        return true;
+    }
+
+    // Loads from the binary cache or compiles; on success replaces p.ID and runs p.setup.
+    // Stamps are taken either way, so a broken file is not retried until it is saved again.
+    bool build(ShaderProgram& p) {
+        p.vertexStamp = stamp(p.vertexPath);
+        p.fragmentStamp = stamp(p.fragmentPath);
+        p.includePaths.clear();
+        std::string vs, fs;
+        bool read = readSource(p.vertexPath, vs, p.includePaths) && readSource(p.fragmentPath, fs, p.includePaths);
+        p.includeStamps.clear();
+        for (const auto& path : p.includePaths) p.includeStamps.push_back(stamp(path));
+        if (!read) return false;
+
+        uint64_t key = hash(fs, hash(vs, driverHash) ^ 0x9E3779B97F4A7C15ull);
+        char name[32];
+        std::snprintf(name, sizeof(name), "/%016llx.bin", (unsigned long long)key);
+        std::string binaryPath = cacheDir + name;
+
+        GLuint program = binaries ? loadBinary(binaryPath) : 0;
+        if (program) fromCache++;
+        else {
+            program = compile(p, vs, fs);
+            if (!program) return false;
+            compiled++;
+            if (binaries) saveBinary(program, binaryPath);
+        }
+
+        if (p.ID) glDeleteProgram(p.ID);
+        p.ID = program;
+        if (p.setup) {
+            glUseProgram(program);
+            p.setup(p);
+        }
+        return true;
+    }
+
+    static GLuint loadBinary(const std::string& path) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) return 0;
+        uint32_t header[3] = { 0, 0, 0 };   // magic, format, length
+        file.read((char*)header, sizeof(header));
+        if (!file || header[0] != BINARY_MAGIC || header[2] == 0) return 0;
+        std::vector<char> data(header[2]);
+        file.read(data.data(), data.size());
+        if (!file) return 0;
+
+        GLuint program = glCreateProgram();
+        glProgramBinary(program, (GLenum)header[1], data.data(), (GLsizei)data.size());
+        GLint ok = 0;
+        glGetProgramiv(program, GL_LINK_STATUS, &ok);
+        if (!ok) {
+            // the driver may reject its own binaries after an update; recompile and overwrite
+            glDeleteProgram(program);
+            return 0;
+        }
+        return program;
+    }
+
+    static void saveBinary(GLuint program, const std::string& path) {
+        GLint length = 0;
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+        if (length <= 0) return;
+        std::vector<char> data(length);
+        GLenum format = 0;
+        glGetProgramBinary(program, length, nullptr, &format, data.data());
+        std::ofstream file(path, std::ios::binary);
+        if (!file) return;
+        uint32_t header[3] = { BINARY_MAGIC, (uint32_t)format, (uint32_t)length };
+        file.write((const char*)header, sizeof(header));
+        file.write(data.data(), data.size());
+    }
+
+    GLuint compile(const ShaderProgram& p, const std::string& vs, const std::string& fs) const {
+        GLuint vertex = compileStage(GL_VERTEX_SHADER, vs, p.vertexPath);
+        GLuint fragment = compileStage(GL_FRAGMENT_SHADER, fs, p.fragmentPath);
+        if (!vertex || !fragment) {
+            if (vertex) glDeleteShader(vertex);
+            if (fragment) glDeleteShader(fragment);
+            return 0;
+        }
+        GLuint program = glCreateProgram();
+        if (binaries) glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        glAttachShader(program, vertex);
+        glAttachShader(program, fragment);
+        glLinkProgram(program);
+        glDeleteShader(vertex);
+        glDeleteShader(fragment);
+        GLint ok = 0;
+        glGetProgramiv(program, GL_LINK_STATUS, &ok);
+        if (!ok) {
+            char log[1024];
+            glGetProgramInfoLog(program, sizeof(log), nullptr, log);
+            std::cerr << "[Shaders] link error (" << p.vertexPath << " + " << p.fragmentPath << "):\n" << log << std::endl;
+            glDeleteProgram(program);
+            return 0;
+        }
+        return program;
+    }
+
+    static GLuint compileStage(GLenum type, const std::string& source, const std::string& path) {
+        const char* src = source.c_str();
+        GLuint shader = glCreateShader(type);
+        glShaderSource(shader, 1, &src, nullptr);
+        glCompileShader(shader);
+        GLint ok = 0;
+        glGetShaderiv(shader, GL_COMPILE_STATUS, &ok);
+        if (!ok) {
+            char log[1024];
+            glGetShaderInfoLog(shader, sizeof(log), nullptr, log);
+            std::cerr << "[Shaders] compile error in " << path << ":\n" << log << std::endl;
+            glDeleteShader(shader);
+            return 0;
+        }
+        return shader;
+    }
+
+    std::vector<std::unique_ptr<ShaderProgram>> programs;
+    std::string cacheDir;
+    bool binaries = false;
+    uint64_t driverHash = FNV_OFFSET;
+    int fromCache = 0, compiled = 0;
+    float loadMs = 0.0f;
+    std::chrono::steady_clock::time_point lastPoll;
+};
+
+#endif
@@ -0,0 +1,179 @@
+#ifndef SHADOW_CASCADES_H
+#define SHADOW_CASCADES_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <cmath>
+#include <iostream>
+
+// Cascaded shadow maps for the directional sun with a cached static layer.
+// Each cascade owns two depth layers: the static one holds only the level geometry and is
+// re-rendered when blocks stream in/out or when the cascade box has to move, the dynamic
+// one is a copy of it with the moving casters (player, coins) drawn on top every frame.
+// Cascade boxes are larger than the camera slice they cover and snap to whole-texel steps
+// in light space, so in steady state the static layers stay valid for many frames and the
+// shadows do not shimmer while the camera moves.
+class ShadowCascades {
+public:
+    static const int CASCADES = 3;
+
+    // view-space far distance of each cascade; shadows fade out over the last fadeRange units
+    float splits[CASCADES] = { 10.0f, 30.0f, 90.0f };
+    float fadeRange = 15.0f;
+    // extra room around each slice, as a fraction of its radius; bigger = fewer static redraws
+    float margin = 0.35f;
+    // light-space depth kept in front of / behind the cascade centre
+    float depthRange = 120.0f;
+
+    void init(int res, const glm::vec3& sunDirection) {
+        dir = glm::normalize(sunDirection);
+        glm::vec3 up = std::fabs(dir.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+        lightRotation = glm::lookAt(glm::vec3(0.0f), dir, up);
+
+        glGenTextures(1, &staticMaps);
+        glGenTextures(1, &dynamicMaps);
+        glGenFramebuffers(CASCADES, staticFBO);
+        glGenFramebuffers(CASCADES, dynamicFBO);
+        resize(res);
+        std::cout << "[Shadows] " << CASCADES << " cascades, " << res << "x" << res << std::endl;
+    }
+
+    // (Re)allocates both layers; everything is re-rendered on the next update. Called from the
+    // frame loop when the quality governor steps, so it does not print.
+    void resize(int res) {
+        resolution = res;
+        allocate(staticMaps, false);
+        allocate(dynamicMaps, true);
+        for (int c = 0; c < CASCADES; ++c) {
+            attach(staticFBO[c], staticMaps, c);
+            attach(dynamicFBO[c], dynamicMaps, c);
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        invalidate();
+    }
+
+    void invalidate() { staticRevision = ~0u; }
+
+    // Fits every cascade around its slice of the view frustum. Returns a bit per cascade
+    // whose static layer must be re-rendered this frame.
+    unsigned int update(const glm::mat4& view, float fovY, float aspect, float zNear, unsigned int levelRevision) {
+        glm::mat4 invView = glm::inverse(view);
+        float tanY = std::tan(fovY * 0.5f), tanX = tanY * aspect;
+        bool levelChanged = levelRevision != staticRevision;
+        staticRevision = levelRevision;
+
+        unsigned int dirty = 0;
+        float sliceNear = zNear;
+        for (int c = 0; c < CASCADES; ++c) {
+            float sliceFar = splits[c];
+
+            // bounding sphere of the slice's eight corners
+            glm::vec3 corners[8];
+            glm::vec3 center(0.0f);
+            for (int i = 0; i < 8; ++i) {
+                float d = (i & 4) ? sliceFar : sliceNear;
+                glm::vec4 p = invView * glm::vec4(((i & 1) ? 1.0f : -1.0f) * tanX * d, ((i & 2) ? 1.0f : -1.0f) * tanY * d, -d, 1.0f);
+                corners[i] = glm::vec3(p);
+                center += corners[i];
+            }
+            center = center / 8.0f;
+            float radius = 0.0f;
+            for (int i = 0; i < 8; ++i) radius = std::fmax(radius, glm::length(corners[i] - center));
+            radius = std::ceil(radius);   // constant for a given fov/aspect, rounded so it never jitters
+
+            // snap the box centre in light space to a whole number of texels
+            float halfExtent = radius * (1.0f + margin);
+            float texel = 2.0f * halfExtent / (float)resolution;
+            float step = std::fmax(texel, std::floor(radius * margin / texel) * texel);
+            glm::vec3 ls = glm::vec3(lightRotation * glm::vec4(center, 1.0f));
+            glm::vec3 snapped(std::floor(ls.x / step + 0.5f) * step,
+                              std::floor(ls.y / step + 0.5f) * step,
+                              std::floor(ls.z / step + 0.5f) * step);
+
+            Cascade& cs = cascades[c];
+            if (levelChanged || snapped != cs.snapped || halfExtent != cs.halfExtent) {
+                cs.snapped = snapped;
+                cs.halfExtent = halfExtent;
+                cs.texelSize = texel;
+                cs.view = glm::translate(glm::mat4(1.0f), -snapped) * lightRotation;
+                cs.proj = glm::ortho(-halfExtent, halfExtent, -halfExtent, halfExtent, -depthRange, depthRange);
+                dirty |= 1u << c;
+            }
+            sliceNear = sliceFar;
+        }
+        return dirty;
+    }
+
+    // Static layer: cleared, then the caller draws the level.
+    void beginStatic(int c) const {
+        glBindFramebuffer(GL_FRAMEBUFFER, staticFBO[c]);
+        glViewport(0, 0, resolution, resolution);
+        glClear(GL_DEPTH_BUFFER_BIT);
+    }
+
+    // Dynamic layer: starts as a copy of the static one, then the caller draws moving casters.
+    void beginDynamic(int c) const {
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, staticFBO[c]);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, dynamicFBO[c]);
+        glBlitFramebuffer(0, 0, resolution, resolution, 0, 0, resolution, resolution, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+        glBindFramebuffer(GL_FRAMEBUFFER, dynamicFBO[c]);
+        glViewport(0, 0, resolution, resolution);
+    }
+
+    const glm::mat4& lightView(int c) const { return cascades[c].view; }
+    const glm::mat4& lightProj(int c) const { return cascades[c].proj; }
+    float texelSize(int c) const { return cascades[c].texelSize; }
+    glm::vec3 direction() const { return dir; }
+    GLuint texture() const { return dynamicMaps; }
+    int size() const { return resolution; }
+
+private:
+    struct Cascade {
+        glm::mat4 view{ 1.0f };
+        glm::mat4 proj{ 1.0f };
+        glm::vec3 snapped{ 0.0f };
+        float halfExtent = 0.0f;
+        float texelSize = 0.0f;
+    };
+
+    void allocate(GLuint tex, bool sampled) const {
+        glBindTexture(GL_TEXTURE_2D_ARRAY, tex);
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT24, resolution, resolution, CASCADES, 0,
+            GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, nullptr);
+        // the dynamic layer is read with hardware depth compare (sampler2DArrayShadow)
+        GLint filter = sampled ? GL_LINEAR : GL_NEAREST;
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, filter);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, filter);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+        const float border[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+        glTexParameterfv(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BORDER_COLOR, border);
+        if (sampled) {
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+        }
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    }
+
+    void attach(GLuint fbo, GLuint tex, int layer) const {
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, tex, 0, layer);
+        glDrawBuffer(GL_NONE);
+        glReadBuffer(GL_NONE);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cerr << "[Shadows] cascade framebuffer " << layer << " incomplete\n";
+    }
+
+    Cascade cascades[CASCADES];
+    glm::mat4 lightRotation{ 1.0f };
+    glm::vec3 dir{ 0.0f, -1.0f, 0.0f };
+    GLuint staticMaps = 0, dynamicMaps = 0;
+    GLuint staticFBO[CASCADES] = { 0, 0, 0 };
+    GLuint dynamicFBO[CASCADES] = { 0, 0, 0 };
+    int resolution = 1024;
+    unsigned int staticRevision = ~0u;
+};
+
+#endif
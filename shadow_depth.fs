@@ -0,0 +1,6 @@
+#version 330 core
+
+// depth-only pass for the shadow cascades; no color attachment is bound
+void main()
+{
+}
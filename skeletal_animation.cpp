@@ -5,264 +5,127 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
-#include <learnopengl/shader_m.h>
 #include <learnopengl/camera.h>
 #include <learnopengl/animator.h>
 #include <learnopengl/model_animation.h>
 
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+
+#include "stream_buffer.h"
+#include "level_batch.h"
+#include "mesh_lod.h"
+#include "skybox.h"
+#include "render_queue.h"
+#include "shadow_cascades.h"
+#include "clustered_lights.h"
+#include "render_target.h"
+#include "input_record.h"
+#include "input_queue.h"
+#include "frame_timings.h"
+#include "camera_rig.h"
+#include "viewport_state.h"
+#include "quality_governor.h"
+#include "level_stream.h"
+#include "game_over_screen.h"
+#include "game_world.h"
+#include "job_system.h"
+#include "shader_cache.h"
+#include "occlusion_buffer.h"
+#include "particles.h"
+#include "draw_list.h"
+#include "run_log.h"
+#define MEMORY_TRACKER_IMPLEMENTATION
+#include "memory_tracker.h"
+
 #include <iostream>
 #include <string>
 #include <vector>
+#include <chrono>
+#include <cstdio>
 #include <cstdlib>
 #include <cmath>
-#include <deque>
+#include <fstream>
 
 // ------------- settings -------------
 const unsigned int SCR_WIDTH = 1280;
 const unsigned int SCR_HEIGHT = 720;
+RenderTarget gTarget;               // window framebuffer or offscreen FBO the frame is presented in
+RenderTarget gScaledTarget;         // reduced-resolution scene, upscaled into gTarget
+RenderTarget* gSceneTarget = &gTarget;   // where this frame's scene is drawn
+ViewportState gViewport;
 
 // ------------- callbacks ------------
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods);
 
 // ------------- timing ---------------
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
+float gClock = 0.0f;   // simulated seconds since launch; drives visual effects so replays match
 
-// ------------- game speed -----------
-float gGameSpeed = 1.0f;
-float gSpeedIncreaseRate = 0.02f;  // How fast speed increases
-float gMaxSpeed = 3.0f;
-float gGameTime = 0.0f;
-
-// ------------- mouse lateral input ---
+// ------------- input ---------------
+// Key and mouse callbacks push timestamped events; each frame's FrameInput is built from them
+InputQueue gInput;
 float g_mouseLastX = SCR_WIDTH * 0.5f;
 bool  g_mouseFirstMove = true;
-float g_mouseDeltaX = 0.0f;
-
-// ------------- game state ------------
-int  gHP = 1;
-int  gCoinCount = 0;
-bool gGameOver = false;
-
-// ------------- player ---------------
-enum class AnimState { Running, Jumping, Sliding };
-
-struct Player {
-    float scale = 1.0f;
-
-    glm::vec3 pos{ 0.0f, 0.0f, 0.0f };
-    glm::vec3 vel{ 0.0f, 0.0f, 0.0f };
-    float yaw = 180.0f;
-    float targetYaw = 180.0f;
-    float forwardVel = 6.0f;
-    float lateralSpeed = 50.0f;
-    float jumpSpeed = 5.0f;
-    float gravity = 12.0f;
-    bool  onGround = true;
-    AnimState state = AnimState::Running;
-
-    float standHalfWidth = 0.35f;
-    float standHalfDepth = 0.25f;
-    float standHeight = 1.8f;
-    float slideHeight = 1.0f;
-
-    bool  sliding = false;
-    float slideTimer = 0.0f;
-    float slideDuration = 1.5f;
-
-    float maxLateral = 4.0f;
-
-    glm::vec3 slideRootStart{ 0.0f, 0.0f, 0.0f };
-    glm::vec3 slideRootCurrent{ 0.0f, 0.0f, 0.0f };
-    bool slideRootInitialized = false;
-
-    float halfW()   const { return standHalfWidth * scale; }
-    float halfD()   const { return standHalfDepth * scale; }
-    float standH()  const { return standHeight * scale; }
-    float slideH()  const { return slideHeight * scale; }
-
-    glm::vec3 getForwardDir() const {
-        float yawRad = glm::radians(yaw);
-        return glm::vec3(sin(yawRad), 0.0f, cos(yawRad));
-    }
-
-    glm::vec3 getRightDir() const {
-        glm::vec3 forward = getForwardDir();
-        return glm::cross(forward, glm::vec3(0.0f, 1.0f, 0.0f));
-    }
-
-    void turnLeft() {
-        if (!sliding && onGround) {
-            yaw += 90.0f;
-            if (yaw >= 360.0f) yaw -= 360.0f;
-        }
-    }
-
-    void turnRight() {
-        if (!sliding && onGround) {
-            yaw -= 90.0f;
-            if (yaw < 0.0f) yaw += 360.0f;
-        }
-    }
-
-    glm::vec3 getSlideOffset() const {
-        if (!slideRootInitialized) return glm::vec3(0.0f);
 
-        glm::vec3 delta = slideRootCurrent - slideRootStart;
-
-        float yawRad = glm::radians(yaw);
-        float c = cos(yawRad);
-        float s = sin(yawRad);
-
-        glm::vec3 worldDelta;
-        worldDelta.x = delta.x * c - delta.z * s;
-        worldDelta.y = 0.0f;
-        worldDelta.z = delta.x * s + delta.z * c;
-
-        return worldDelta;
-    }
-
-    std::vector<glm::mat4> removeRootMotion(std::vector<glm::mat4> bones) const {
-        if (!sliding || !slideRootInitialized || bones.empty()) return bones;
-
-        glm::vec3 delta = slideRootCurrent - slideRootStart;
-        delta.y = 0.0f;
-
-        glm::mat4 cancelMat = glm::translate(glm::mat4(1.0f), -delta);
-
-        for (size_t i = 0; i < bones.size(); ++i) {
-            bones[i] = cancelMat * bones[i];
-        }
-
-        return bones;
-    }
-
-    void bakeSlideRootMotion() {
-        if (!slideRootInitialized) return;
-
-        glm::vec3 slideOffset = getSlideOffset();
-        pos += slideOffset;
-
-        std::cout << "Baked slide offset: (" << slideOffset.x << ", " << slideOffset.z << ")\n";
-        std::cout << "New player.pos: (" << pos.x << ", " << pos.z << ")\n";
-    }
-
-    void startSlide() {
-        if (onGround && !sliding) {
-            sliding = true;
-            slideTimer = slideDuration;
-            state = AnimState::Sliding;
-            slideRootInitialized = false;
-        }
-    }
-
-    void updatePhysics(float dt, float mouseDeltaX) {
-        glm::vec3 forward = getForwardDir();
-        pos += forward * forwardVel * dt;
-
-        const float MOUSE_SENS = 0.02f;
-        float lateralMove = mouseDeltaX * MOUSE_SENS * lateralSpeed;
-        glm::vec3 right = getRightDir();
-        pos += right * lateralMove * dt;
-
-        if (!sliding) {
-            if (!onGround) vel.y -= gravity * dt;
-            pos.y += vel.y * dt;
-            if (pos.y <= 0.0f) {
-                pos.y = 0.0f; vel.y = 0.0f;
-                if (!onGround) { onGround = true; state = AnimState::Running; }
-            }
-        }
-        else {
-            pos.y = 0.0f; vel.y = 0.0f;
-        }
-
-        if (sliding) {
-            slideTimer -= dt;
-            if (slideTimer <= 0.0f) {
-                sliding = false;
-                state = AnimState::Running;
-                slideRootInitialized = false;
-            }
-        }
-    }
-
-    void jump() {
-        if (onGround && !sliding) {
-            onGround = false;
-            vel.y = jumpSpeed;
-            state = AnimState::Jumping;
-        }
-    }
-
-    void getAABB(glm::vec3& minOut, glm::vec3& maxOut) const {
-        float h = sliding ? slideH() : standH();
-        glm::vec3 actualPos = pos;
-        if (sliding && slideRootInitialized) {
-            glm::vec3 slideOffset = getSlideOffset();
-            actualPos += slideOffset;
-        }
-        minOut = glm::vec3(actualPos.x - halfW(), 0.0f, actualPos.z - halfD());
-        maxOut = glm::vec3(actualPos.x + halfW(), actualPos.y + h, actualPos.z + halfD());
-    }
+// ------------- world ------------------
+// The game's run, and a copy of its start that restarts are restored from
+World gWorld;
+World gWorldStart;
+const unsigned int LEVEL_SEED = 1234567u;   // fixed, so recorded inputs replay the same run
 
-    void updateSlideRootMotion(const std::vector<glm::mat4>& boneMatrices) {
-        if (!sliding || boneMatrices.empty()) return;
+// ------------- shaders ------------------
+// Every program of the game; linked binaries are cached on disk and can be hot-reloaded
+ShaderCache gShaders;
 
-        glm::vec3 currentRoot = glm::vec3(boneMatrices[0][3]);
-
-        if (!slideRootInitialized) {
-            slideRootStart = currentRoot;
-            slideRootInitialized = true;
-        }
-
-        slideRootCurrent = currentRoot;
-    }
-
-} player;
+// ------------- jobs ------------------
+// Shared by every parallel system; the main thread is worker 0 and keeps all GL calls
+JobSystem gJobs;
 
 // ------------- camera ----------
-glm::vec3 camPos(0.0f, 3.0f, 6.5f);
-glm::vec3 camTarget(0.0f, 1.2f, -4.0f);
-float camYaw = 180.0f;
-float camLerpSpeed = 5.0f;
-float camRotationSpeed = 8.0f;
-
-glm::mat4 computeFixedChaseCamView() {
-    float yawDiff = player.yaw - camYaw;
-
-    if (yawDiff > 180.0f) yawDiff -= 360.0f;
-    if (yawDiff < -180.0f) yawDiff += 360.0f;
-
-    camYaw += yawDiff * camRotationSpeed * deltaTime;
-
-    if (camYaw < 0.0f) camYaw += 360.0f;
-    if (camYaw >= 360.0f) camYaw -= 360.0f;
-
-    float camYawRad = glm::radians(camYaw);
-
-    glm::vec3 playerForward = glm::vec3(sin(camYawRad), 0.0f, cos(camYawRad));
-    glm::vec3 camBack = -playerForward;
-    glm::vec3 desiredOffset = camBack * 6.5f + glm::vec3(0.0f, 3.0f, 0.0f);
-    glm::vec3 desiredLookOffset = playerForward * 4.0f + glm::vec3(0.0f, 1.2f, 0.0f);
-
-    if (player.sliding) {
-        desiredOffset.y = 2.0f;
-    }
+// Updated in the simulation tick; rendering only reads the published snapshot.
+CameraRig gCameraRig;
+CameraSnapshot gCamera;
+
+void updateCamera(float dt) {
+    glm::vec3 followPos = gWorld.player.pos;
+    if (gWorld.player.sliding) followPos += gWorld.player.getSlideOffset();
+    gCameraRig.update(followPos, gWorld.player.yaw, gWorld.player.sliding, dt);
+    gCamera = gCameraRig.snapshot(gViewport.lens(), gViewport.projection());
+}
 
-    glm::vec3 actualPlayerPos = player.pos;
-    if (player.sliding) {
-        actualPlayerPos += player.getSlideOffset();
+// Picks where the scene is drawn this frame: straight into the output, or into the
+// reduced-resolution target that endScene() upscales.
+void beginScene() {
+    gSceneTarget = &gTarget;
+    if (gViewport.scaled()) {
+        int w = gViewport.sceneWidth(), h = gViewport.sceneHeight();
+        if (!gScaledTarget.isOffscreen()) gScaledTarget.initOffscreen(w, h);
+        else if (gScaledTarget.getWidth() != w || gScaledTarget.getHeight() != h) gScaledTarget.resize(w, h);
+        gSceneTarget = &gScaledTarget;
     }
+    gSceneTarget->bind();
+}
 
-    glm::vec3 targetPos = actualPlayerPos + desiredOffset;
-    glm::vec3 targetLook = actualPlayerPos + desiredLookOffset;
+void endScene() {
+    if (gSceneTarget == &gTarget) return;
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, gScaledTarget.framebuffer());
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, gTarget.framebuffer());
+    glBlitFramebuffer(0, 0, gScaledTarget.getWidth(), gScaledTarget.getHeight(),
+        0, 0, gTarget.getWidth(), gTarget.getHeight(), GL_COLOR_BUFFER_BIT, GL_LINEAR);
+    gTarget.bind();
+}
 
-    camPos = glm::mix(camPos, targetPos, camLerpSpeed * deltaTime);
-    camTarget = glm::mix(camTarget, targetLook, camLerpSpeed * deltaTime);
+// ------------- assets ------------------
+// Models and textures are loaded by file name from one directory: --assets, else TR_ASSETS,
+// else the working directory (the repository root holds all of them).
+std::string gAssetDir = ".";
 
-    return glm::lookAt(camPos, camTarget, glm::vec3(0.0f, 1.0f, 0.0f));
+std::string assetPath(const std::string& name) {
+    return gAssetDir + "/" + name;
 }
 
 // ------------- texture loading ------------------
@@ -291,6 +154,149 @@ unsigned int LoadTexture2D(const std::string& fullPath, bool flip = true) {
     return tex;
 }
 
+// ------------- per-frame GPU data ------------------
+// Uniform block binding points shared by every shader (see FrameData/ObjectData in the .vs files)
+const GLuint UBO_FRAME = 0;
+const GLuint UBO_OBJECT = 1;
+const GLuint UBO_SHADOW = 2;
+const GLuint UBO_CLUSTER = 3;
+const int BONE_PALETTE_UNIT = 7;   // texture unit of the bone palette buffer texture
+const int SHADOW_MAP_UNIT = 8;     // texture unit of the cascaded shadow map array
+const int CLUSTER_LIST_UNIT = 9;   // texture unit of the light cluster grid / index lists
+
+struct FrameDataStd140 {
+    glm::mat4 projection;
+    glm::mat4 view;
+    glm::vec4 viewPos;
+    glm::vec4 lightPos;
+};
+
+// skin.x = first palette texel, skin.y = texels per instance, skin.z = bone count (0 = rigid)
+struct ObjectDataStd140 {
+    glm::mat4 model;
+    glm::ivec4 skin;
+};
+
+struct ShadowDataStd140 {
+    glm::mat4 lightViewProj[3];
+    glm::vec4 cascadeSplits;   // xyz = cascade far distances, w = fade start
+    glm::vec4 cascadeTexel;
+    glm::vec4 sunDirection;
+    glm::vec4 sunColor;        // w = ambient strength
+};
+
+StreamBuffer gStream;
+unsigned int gBonePaletteTexture = 0;
+
+void bindUniformBlocks(ShaderProgram& shader) {
+    const char* names[] = { "FrameData", "ObjectData", "ShadowData", "ClusterData" };
+    const GLuint bindings[] = { UBO_FRAME, UBO_OBJECT, UBO_SHADOW, UBO_CLUSTER };
+    for (int i = 0; i < 4; ++i) {
+        GLuint idx = glGetUniformBlockIndex(shader.ID, names[i]);
+        if (idx != GL_INVALID_INDEX)
+            glUniformBlockBinding(shader.ID, idx, bindings[i]);
+    }
+}
+
+// Bone palettes live in the same ring buffer, viewed through an RGBA32F buffer texture.
+// A bone is a 3x4 matrix (three texels, one per row), so there is no fixed bone limit
+// and a palette is 48 bytes per bone instead of 64.
+void initBonePalette() {
+    GLint maxTexels = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+    if ((long long)maxTexels * 16 < (long long)gStream.totalSize())
+        std::cerr << "[Bones] ring buffer exceeds GL_MAX_TEXTURE_BUFFER_SIZE (" << maxTexels << " texels)\n";
+
+    glGenTextures(1, &gBonePaletteTexture);
+    glActiveTexture(GL_TEXTURE0 + BONE_PALETTE_UNIT);
+    glBindTexture(GL_TEXTURE_BUFFER, gBonePaletteTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, gStream.id());
+    glActiveTexture(GL_TEXTURE0);
+}
+
+static void packBone(glm::vec4* dst, const glm::mat4& m) {
+    dst[0] = glm::vec4(m[0][0], m[1][0], m[2][0], m[3][0]);
+    dst[1] = glm::vec4(m[0][1], m[1][1], m[2][1], m[3][1]);
+    dst[2] = glm::vec4(m[0][2], m[1][2], m[2][2], m[3][2]);
+}
+
+StreamBuffer::Alloc streamModelMatrix(const glm::mat4& model, const glm::ivec4& skin = glm::ivec4(0)) {
+    ObjectDataStd140 object;
+    object.model = model;
+    object.skin = skin;
+    return gStream.write(&object, sizeof(object));
+}
+
+// Returns the skin descriptor (first texel, 0, bone count) for ObjectData, or bone count 0 when out of space.
+glm::ivec4 streamBones(const std::vector<glm::mat4>& bones) {
+    StreamBuffer::Alloc a = gStream.allocate(sizeof(glm::vec4) * 3 * bones.size());
+    if (!a.valid()) return glm::ivec4(0);
+    glm::vec4* dst = (glm::vec4*)a.ptr;
+    for (size_t i = 0; i < bones.size(); ++i)
+        packBone(dst + i * 3, bones[i]);
+    return glm::ivec4((int)(a.offset / sizeof(glm::vec4)), 0, (int)bones.size(), 0);
+}
+
+// Instanced palettes: per instance, its world transform followed by its bones.
+// Draw with glDrawElementsInstanced and skin.y = texels per instance.
+glm::ivec4 streamBoneInstances(const std::vector<glm::mat4>& transforms, const std::vector<std::vector<glm::mat4>>& bones) {
+    if (transforms.empty() || bones.size() != transforms.size()) return glm::ivec4(0);
+    size_t boneCount = bones[0].size();
+    size_t texelsPerInstance = (boneCount + 1) * 3;
+    StreamBuffer::Alloc a = gStream.allocate(sizeof(glm::vec4) * texelsPerInstance * transforms.size());
+    if (!a.valid()) return glm::ivec4(0);
+    glm::vec4* dst = (glm::vec4*)a.ptr;
+    for (size_t n = 0; n < transforms.size(); ++n) {
+        glm::vec4* inst = dst + n * texelsPerInstance;
+        packBone(inst, transforms[n]);
+        for (size_t i = 0; i < boneCount && i < bones[n].size(); ++i)
+            packBone(inst + 3 + i * 3, bones[n][i]);
+    }
+    return glm::ivec4((int)(a.offset / sizeof(glm::vec4)), (int)texelsPerInstance, (int)boneCount, 0);
+}
+
+// ------------- level geometry ------------------
+static const LevelVertex kUnitCubeVerts[] = {
+    {+0.5f,-0.5f,-0.5f, 1,0,0, 0,0, 0,0,0,0, 1,0,0,0},
+    {+0.5f,+0.5f,-0.5f, 1,0,0, 1,0, 0,0,0,0, 1,0,0,0},
+    {+0.5f,+0.5f,+0.5f, 1,0,0, 1,1, 0,0,0,0, 1,0,0,0},
+    {+0.5f,-0.5f,+0.5f, 1,0,0, 0,1, 0,0,0,0, 1,0,0,0},
+    {-0.5f,-0.5f,+0.5f,-1,0,0, 0,0, 0,0,0,0, 1,0,0,0},
+    {-0.5f,+0.5f,+0.5f,-1,0,0, 1,0, 0,0,0,0, 1,0,0,0},
+    {-0.5f,+0.5f,-0.5f,-1,0,0, 1,1, 0,0,0,0, 1,0,0,0},
+    {-0.5f,-0.5f,-0.5f,-1,0,0, 0,1, 0,0,0,0, 1,0,0,0},
+    {-0.5f,+0.5f,-0.5f, 0,1,0, 0,0, 0,0,0,0, 1,0,0,0},
+    {-0.5f,+0.5f,+0.5f, 0,1,0, 0,1, 0,0,0,0, 1,0,0,0},
+    {+0.5f,+0.5f,+0.5f, 0,1,0, 1,1, 0,0,0,0, 1,0,0,0},
+    {+0.5f,+0.5f,-0.5f, 0,1,0, 1,0, 0,0,0,0, 1,0,0,0},
+    {-0.5f,-0.5f,+0.5f, 0,-1,0, 0,0, 0,0,0,0, 1,0,0,0},
+    {-0.5f,-0.5f,-0.5f, 0,-1,0, 0,1, 0,0,0,0, 1,0,0,0},
+    {+0.5f,-0.5f,-0.5f, 0,-1,0, 1,1, 0,0,0,0, 1,0,0,0},
+    {+0.5f,-0.5f,+0.5f, 0,-1,0, 1,0, 0,0,0,0, 1,0,0,0},
+    {-0.5f,-0.5f,+0.5f, 0,0,1, 0,0, 0,0,0,0, 1,0,0,0},
+    {+0.5f,-0.5f,+0.5f, 0,0,1, 1,0, 0,0,0,0, 1,0,0,0},
+    {+0.5f,+0.5f,+0.5f, 0,0,1, 1,1, 0,0,0,0, 1,0,0,0},
+    {-0.5f,+0.5f,+0.5f, 0,0,1, 0,1, 0,0,0,0, 1,0,0,0},
+    {+0.5f,-0.5f,-0.5f, 0,0,-1, 0,0, 0,0,0,0, 1,0,0,0},
+    {-0.5f,-0.5f,-0.5f, 0,0,-1, 1,0, 0,0,0,0, 1,0,0,0},
+    {-0.5f,+0.5f,-0.5f, 0,0,-1, 1,1, 0,0,0,0, 1,0,0,0},
+    {+0.5f,+0.5f,-0.5f, 0,0,-1, 0,1, 0,0,0,0, 1,0,0,0},
+};
+static const unsigned int kUnitCubeIdx[] = {
+    0,1,2, 0,2,3, 4,5,6, 4,6,7,
+    8,9,10, 8,10,11, 12,13,14, 12,14,15,
+    16,17,18, 16,18,19, 20,21,22, 20,22,23
+};
+
+// Unit square floor
+static const LevelVertex kFloorVerts[] = {
+    {-0.5f, 0.0f,  0.5f, 0,1,0,  0.0f, 1.0f,  0,0,0,0, 1,0,0,0},
+    { 0.5f, 0.0f,  0.5f, 0,1,0,  1.0f, 1.0f,  0,0,0,0, 1,0,0,0},
+    { 0.5f, 0.0f, -0.5f, 0,1,0,  1.0f, 0.0f,  0,0,0,0, 1,0,0,0},
+    {-0.5f, 0.0f, -0.5f, 0,1,0,  0.0f, 0.0f,  0,0,0,0, 1,0,0,0},
+};
+static const unsigned int kFloorIdx[] = { 0,1,2, 0,2,3 };
+
 // ------------- static mesh ------------------
 struct StaticMesh {
     unsigned int VAO = 0, VBO = 0, EBO = 0;
@@ -298,85 +304,31 @@ struct StaticMesh {
     int indexCount = 0;
 
     void initUnitCube(const std::string& texPath) {
-        struct V {
-            float px, py, pz, nx, ny, nz, u, v, bid0, bid1, bid2, bid3, w0, w1, w2, w3;
-        };
-        const V v[] = {
-            {+0.5f,-0.5f,-0.5f, 1,0,0, 0,0, 0,0,0,0, 1,0,0,0},
-            {+0.5f,+0.5f,-0.5f, 1,0,0, 1,0, 0,0,0,0, 1,0,0,0},
-            {+0.5f,+0.5f,+0.5f, 1,0,0, 1,1, 0,0,0,0, 1,0,0,0},
-            {+0.5f,-0.5f,+0.5f, 1,0,0, 0,1, 0,0,0,0, 1,0,0,0},
-            {-0.5f,-0.5f,+0.5f,-1,0,0, 0,0, 0,0,0,0, 1,0,0,0},
-            {-0.5f,+0.5f,+0.5f,-1,0,0, 1,0, 0,0,0,0, 1,0,0,0},
-            {-0.5f,+0.5f,-0.5f,-1,0,0, 1,1, 0,0,0,0, 1,0,0,0},
-            {-0.5f,-0.5f,-0.5f,-1,0,0, 0,1, 0,0,0,0, 1,0,0,0},
-            {-0.5f,+0.5f,-0.5f, 0,1,0, 0,0, 0,0,0,0, 1,0,0,0},
-            {-0.5f,+0.5f,+0.5f, 0,1,0, 0,1, 0,0,0,0, 1,0,0,0},
-            {+0.5f,+0.5f,+0.5f, 0,1,0, 1,1, 0,0,0,0, 1,0,0,0},
-            {+0.5f,+0.5f,-0.5f, 0,1,0, 1,0, 0,0,0,0, 1,0,0,0},
-            {-0.5f,-0.5f,+0.5f, 0,-1,0, 0,0, 0,0,0,0, 1,0,0,0},
-            {-0.5f,-0.5f,-0.5f, 0,-1,0, 0,1, 0,0,0,0, 1,0,0,0},
-            {+0.5f,-0.5f,-0.5f, 0,-1,0, 1,1, 0,0,0,0, 1,0,0,0},
-            {+0.5f,-0.5f,+0.5f, 0,-1,0, 1,0, 0,0,0,0, 1,0,0,0},
-            {-0.5f,-0.5f,+0.5f, 0,0,1, 0,0, 0,0,0,0, 1,0,0,0},
-            {+0.5f,-0.5f,+0.5f, 0,0,1, 1,0, 0,0,0,0, 1,0,0,0},
-            {+0.5f,+0.5f,+0.5f, 0,0,1, 1,1, 0,0,0,0, 1,0,0,0},
-            {-0.5f,+0.5f,+0.5f, 0,0,1, 0,1, 0,0,0,0, 1,0,0,0},
-            {+0.5f,-0.5f,-0.5f, 0,0,-1, 0,0, 0,0,0,0, 1,0,0,0},
-            {-0.5f,-0.5f,-0.5f, 0,0,-1, 1,0, 0,0,0,0, 1,0,0,0},
-            {-0.5f,+0.5f,-0.5f, 0,0,-1, 1,1, 0,0,0,0, 1,0,0,0},
-            {+0.5f,+0.5f,-0.5f, 0,0,-1, 0,1, 0,0,0,0, 1,0,0,0},
-        };
-        const unsigned int idx[] = {
-            0,1,2, 0,2,3, 4,5,6, 4,6,7,
-            8,9,10, 8,10,11, 12,13,14, 12,14,15,
-            16,17,18, 16,18,19, 20,21,22, 20,22,23
-        };
-
         glGenVertexArrays(1, &VAO);
         glGenBuffers(1, &VBO);
         glGenBuffers(1, &EBO);
         glBindVertexArray(VAO);
         glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(v), v, GL_STATIC_DRAW);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(kUnitCubeVerts), kUnitCubeVerts, GL_STATIC_DRAW);
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(idx), idx, GL_STATIC_DRAW);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(kUnitCubeIdx), kUnitCubeIdx, GL_STATIC_DRAW);
 
-        GLsizei stride = sizeof(V);
+        GLsizei stride = sizeof(LevelVertex);
         glEnableVertexAttribArray(0);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(V, px));
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(LevelVertex, px));
         glEnableVertexAttribArray(1);
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(V, nx));
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(LevelVertex, nx));
         glEnableVertexAttribArray(2);
-        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(V, u));
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(LevelVertex, u));
         glEnableVertexAttribArray(5);
-        glVertexAttribIPointer(5, 4, GL_INT, stride, (void*)offsetof(V, bid0));
+        glVertexAttribIPointer(5, 4, GL_INT, stride, (void*)offsetof(LevelVertex, bid0));
         glEnableVertexAttribArray(6);
-        glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(V, w0));
+        glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(LevelVertex, w0));
 
         glBindVertexArray(0);
         texture = LoadTexture2D(texPath, true);
         indexCount = 36;
     }
-
-    void draw(Shader& animShader, const glm::vec3& pos, const glm::vec3& size) {
-        glm::mat4 I(1.0f);
-        for (int i = 0; i < 100; ++i)
-            animShader.setMat4("finalBonesMatrices[" + std::to_string(i) + "]", I);
-
-        glm::mat4 M(1.0f);
-        M = glm::translate(M, pos);
-        M = glm::scale(M, size);
-        animShader.setMat4("model", M);
-
-        animShader.setInt("texture_diffuse1", 0);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, texture);
-
-        glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
-    }
 };
 
 // ------------- floor plane ------------------
@@ -386,648 +338,871 @@ struct FloorTile {
     static bool textureLoaded;
 
     void init() {
-        struct V {
-            float px, py, pz, nx, ny, nz, u, v, bid0, bid1, bid2, bid3, w0, w1, w2, w3;
-        };
-        // Unit square floor
-        const V verts[] = {
-            {-0.5f, 0.0f,  0.5f, 0,1,0,  0.0f, 1.0f,  0,0,0,0, 1,0,0,0},
-            { 0.5f, 0.0f,  0.5f, 0,1,0,  1.0f, 1.0f,  0,0,0,0, 1,0,0,0},
-            { 0.5f, 0.0f, -0.5f, 0,1,0,  1.0f, 0.0f,  0,0,0,0, 1,0,0,0},
-            {-0.5f, 0.0f, -0.5f, 0,1,0,  0.0f, 0.0f,  0,0,0,0, 1,0,0,0},
-        };
-        const unsigned int idx[] = { 0,1,2, 0,2,3 };
-
         glGenVertexArrays(1, &VAO);
         glGenBuffers(1, &VBO);
         glGenBuffers(1, &EBO);
 
         glBindVertexArray(VAO);
         glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(verts), verts, GL_STATIC_DRAW);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(kFloorVerts), kFloorVerts, GL_STATIC_DRAW);
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(idx), idx, GL_STATIC_DRAW);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(kFloorIdx), kFloorIdx, GL_STATIC_DRAW);
 
-        GLsizei stride = sizeof(V);
+        GLsizei stride = sizeof(LevelVertex);
         glEnableVertexAttribArray(0);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(V, px));
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(LevelVertex, px));
         glEnableVertexAttribArray(1);
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(V, nx));
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(LevelVertex, nx));
         glEnableVertexAttribArray(2);
-        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(V, u));
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(LevelVertex, u));
         glEnableVertexAttribArray(5);
-        glVertexAttribIPointer(5, 4, GL_INT, stride, (void*)offsetof(V, bid0));
+        glVertexAttribIPointer(5, 4, GL_INT, stride, (void*)offsetof(LevelVertex, bid0));
         glEnableVertexAttribArray(6);
-        glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(V, w0));
+        glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(LevelVertex, w0));
         glBindVertexArray(0);
 
         if (!textureLoaded) {
-            sharedTexture = LoadTexture2D("C:/Users/User/source/repos/LearnOpenGL/resources/textures/darkwood.jpg", true);
+            sharedTexture = LoadTexture2D(assetPath("darkwood.jpg"), true);
             textureLoaded = true;
         }
     }
-
-    void draw(Shader& animShader, const glm::vec3& pos, float size) {
-        glm::mat4 I(1.0f);
-        for (int i = 0; i < 100; ++i)
-            animShader.setMat4("finalBonesMatrices[" + std::to_string(i) + "]", I);
-
-        glm::mat4 M(1.0f);
-        M = glm::translate(M, pos);
-        M = glm::scale(M, glm::vec3(size, 1.0f, size));
-        animShader.setMat4("model", M);
-
-        animShader.setInt("texture_diffuse1", 0);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, sharedTexture);
-
-        glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
-    }
 };
 
 unsigned int FloorTile::sharedTexture = 0;
 bool FloorTile::textureLoaded = false;
 
-// ------------- collision util ------------------
-static inline bool AABBIntersect(const glm::vec3& amin, const glm::vec3& amax,
-    const glm::vec3& bmin, const glm::vec3& bmax) {
-    return (amin.x <= bmax.x && amax.x >= bmin.x) &&
-        (amin.y <= bmax.y && amax.y >= bmin.y) &&
-        (amin.z <= bmax.z && amax.z >= bmin.z);
-}
-
-// ------------- random ------------------
-unsigned int gRandState = 1234567u;
+// ------------- draw range ------------------
+// Only the first gDrawBlocksAhead live blocks in front of the player are rendered; the
+// quality governor shortens that under CPU load.
+int gDrawBlocksAhead = 50;
 
-static float frand01() {
-    gRandState = 1664525u * gRandState + 1013904223u;
-    return (gRandState >> 8) * (1.0f / 16777216.0f);
+static bool inDrawRange(const Block& block) {
+    return inDrawRange(gWorld, block, gDrawBlocksAhead);
 }
 
-static int randInt(int min, int max) {
-    return min + (int)(frand01() * (max - min + 1));
+// A shortened draw distance moves with the player, so the level batch and the static shadow
+// layers have to be rebuilt when the player enters the next block.
+void trackDrawRange() {
+    static int drawnFrom = -1;
+    if (gWorld.playerBlock == drawnFrom) return;
+    drawnFrom = gWorld.playerBlock;
+    if (gDrawBlocksAhead < gWorld.streaming.blocksAhead(Block::SIZE)) gWorld.revision++;
 }
 
-// ------------- Block-based generation ------------------
-enum class BlockType {
-    Normal,
-    TurnLeft,
-    TurnRight,
-    TurnStraight
-};
-
-enum class ObsType { None, JumpWall, SlideGate };
-
-struct Wall {
-    glm::vec3 pos, size;
-};
-
-struct Obstacle {
-    ObsType type = ObsType::None;
-    glm::vec3 pos, size;
-    bool hit = false;
+static_assert((int)LEVEL_MESH_FLOOR == (int)LevelBatch::MESH_FLOOR && (int)LEVEL_MESH_BOX == (int)LevelBatch::MESH_BOX,
+    "forEachLevelPiece meshes index the level batch");
+
+// ------------- occlusion ------------------
+// The floors and walls of the blocks just ahead (corridor sides and the front wall of every
+// turn) are rasterized into a small CPU depth buffer once the camera is known, and every level
+// piece and coin in draw range is tested against it. The camera looks down over the 2-unit
+// walls, so what they hide is mostly the floor, obstacles and coins of the corridor past the
+// next turn. Hidden pieces are skipped by both level paths but still cast shadows.
+OcclusionBuffer gOcclusion;
+bool gUseOcclusion = true;
+const int OCCLUDER_BLOCKS = 12;
+std::vector<uint8_t> gPieceVisible;   // per level piece in draw range, forEachLevelPiece order
+int gPiecesOccluded = 0;
+int gCoinsOccluded = 0;
+
+// The floor tile is a flat quad; its size.y only feeds the frustum bounds
+static void occlusionBounds(LevelMesh mesh, const glm::vec3& pos, const glm::vec3& size, glm::vec3& mn, glm::vec3& mx) {
+    mn = pos - size * 0.5f;
+    mx = pos + size * 0.5f;
+    if (mesh == LEVEL_MESH_FLOOR) mn.y = mx.y = pos.y;
+}
 
-    void getAABB(glm::vec3& mn, glm::vec3& mx) const {
-        mn = pos - size * 0.5f;
-        mx = pos + size * 0.5f;
+// Frame job, after the camera
+void cullOccluded(const CameraSnapshot& cam) {
+    gPieceVisible.clear();
+    gPiecesOccluded = 0;
+    if (!gUseOcclusion) return;
+
+    // Floors and side walls of a straight run are separate boxes; merging the ones that line
+    // up end to end keeps the seams between them from staying uncovered (only whole pixels count).
+    const int maxOccluders = OCCLUDER_BLOCKS * 4;
+    glm::vec3 occMin[maxOccluders], occMax[maxOccluders];
+    int occluders = 0;
+    int first = std::max(gWorld.playerBlock, 0);
+    for (const auto& block : gWorld.blocks) {
+        if (block.blockIndex < first || !inDrawRange(block)) continue;
+        if (block.blockIndex >= first + OCCLUDER_BLOCKS) break;
+        forEachLevelPiece(block, [&](LevelMesh mesh, const glm::vec3& pos, const glm::vec3& size) {
+            if (mesh == LEVEL_MESH_BOX && size.y < Block::WALL_HEIGHT) return;   // not obstacles
+            glm::vec3 mn, mx;
+            occlusionBounds(mesh, pos, size, mn, mx);
+            for (int i = 0; i < occluders; ++i) {
+                int same = 0, axis = -1;
+                for (int a = 0; a < 3; ++a) {
+                    if (std::fabs(occMin[i][a] - mn[a]) < 1e-3f && std::fabs(occMax[i][a] - mx[a]) < 1e-3f) same++;
+                    else axis = a;
+                }
+                if (same != 2) continue;
+                if (std::fabs(occMax[i][axis] - mn[axis]) < 1e-3f) { occMax[i][axis] = mx[axis]; return; }
+                if (std::fabs(occMin[i][axis] - mx[axis]) < 1e-3f) { occMin[i][axis] = mn[axis]; return; }
+            }
+            if (occluders < maxOccluders) {
+                occMin[occluders] = mn;
+                occMax[occluders] = mx;
+                occluders++;
+            }
+        });
     }
-};
-
-struct Block {
-    int blockIndex;
-    BlockType type;
-    glm::vec3 centerPos;
-    float yaw;
-
-    Wall leftWall;
-    Wall rightWall;
-    Wall frontWall;
-    bool hasFrontWall = false;
-
-    Obstacle obstacle;
-    bool hasObstacle = false;
-
-    // Coins
-    struct Coin {
-        glm::vec3 pos;
-        bool collected = false;
-        float rotation = 0.0f;
-    };
-    std::vector<Coin> coins;
-
-    // Block size
-    static constexpr float SIZE = 5.0f;  // 5x5 units
-    static constexpr float WALL_HEIGHT = 2.0f;
-    static constexpr float WALL_THICKNESS = 0.5f;
-};
+    gOcclusion.begin(cam.viewProj, cam.position);
+    for (int i = 0; i < occluders; ++i) gOcclusion.addOccluder(occMin[i], occMax[i]);
+
+    for (const auto& block : gWorld.blocks) {
+        if (!inDrawRange(block)) continue;
+        forEachLevelPiece(block, [&](LevelMesh mesh, const glm::vec3& pos, const glm::vec3& size) {
+            glm::vec3 mn, mx;
+            occlusionBounds(mesh, pos, size, mn, mx);
+            bool visible = gOcclusion.visible(mn, mx);
+            gPieceVisible.push_back(visible ? 1 : 0);
+            if (!visible) gPiecesOccluded++;
+        });
+    }
+}
 
-std::deque<Block> gBlocks;
 FloorTile gFloorTile;
 StaticMesh gBox;
 
-int gNextBlockIndex = 0;
-glm::vec3 gNextBlockCenter(0.0f, 0.0f, 0.0f);
-float gCurrentBuildYaw = 180.0f;
+// What a live block costs: the record (coins are stored inline) on the CPU, plus the GPU records
+// it produces (batch instance, bounds and draw command per piece; object data, impostor and
+// glow light per coin; one torch light).
+size_t blockFootprint(const Block& block) {
+    size_t pieces = 1 + (block.leftWall.size.x > 0.1f) + (block.rightWall.size.x > 0.1f) + block.hasFrontWall + block.hasObstacle;
+    size_t cpu = sizeof(Block);
+    size_t gpu = pieces * (sizeof(LevelInstance) + sizeof(LevelBounds) + sizeof(DrawElementsIndirectCommand))
+        + block.coins.size() * (sizeof(ObjectDataStd140) + 3 * sizeof(glm::vec4))
+        + 2 * sizeof(glm::vec4);
+    return cpu + gpu;
+}
 
-// Coin generation state
-bool gCoinOnLeftSide = true;
-int gCoinPatternStart = -1;
-bool gCoinSwitchAtBlock4 = false;
+// ------------- render queue ------------------
+RenderQueue gRenderQueue;
+glm::vec3 gQueueEye(0.0f);   // camera position used for front-to-back depth
 
-glm::vec3 getDirectionFromYaw(float yaw) {
-    float yawRad = glm::radians(yaw);
-    return glm::vec3(sin(yawRad), 0.0f, cos(yawRad));
+// Shadow casters recorded alongside the queue items (same geometry and ObjectData ranges)
+struct ShadowCaster {
+    unsigned int vao;
+    int indexCount;
+    StreamBuffer::Alloc object;
+};
+std::vector<ShadowCaster> gLevelCasters;    // per-draw level path only
+std::vector<ShadowCaster> gCoinCasters;
+std::vector<ShadowCaster> gPlayerCasters;
+
+static void pushMeshItem(RenderPass pass, unsigned int program, unsigned int texture, unsigned int vao, int indexCount,
+    const StreamBuffer::Alloc& object, const glm::vec3& pos) {
+    MeshDraw mesh;
+    mesh.texture = texture;
+    mesh.vao = vao;
+    mesh.indexCount = indexCount;
+    pushMeshItem(gRenderQueue, gQueueEye, pass, program, mesh, object.offset, object.size, pos);
 }
 
-// Helper to get perpendicular right direction
-glm::vec3 getRightFromYaw(float yaw) {
-    glm::vec3 forward = getDirectionFromYaw(yaw);
-    return glm::cross(forward, glm::vec3(0.0f, 1.0f, 0.0f));
+static void addCaster(std::vector<ShadowCaster>& casters, const MeshDraw& mesh, const StreamBuffer::Alloc& object) {
+    casters.push_back({ mesh.vao, mesh.indexCount, object });
 }
 
-Block createBlock(int index, BlockType type, glm::vec3 center, float yaw) {
-    Block block;
-    block.blockIndex = index;
-    block.type = type;
-    block.centerPos = center;
-    block.yaw = yaw;
-
-    glm::vec3 forward = getDirectionFromYaw(yaw);
-    glm::vec3 right = getRightFromYaw(yaw);
-
-    float halfSize = Block::SIZE * 0.5f;
-
-    if (type == BlockType::Normal || type == BlockType::TurnStraight) {
-        block.leftWall.pos = center - right * (halfSize + Block::WALL_THICKNESS * 0.5f)
-            + glm::vec3(0.0f, Block::WALL_HEIGHT * 0.5f, 0.0f);
-        block.leftWall.size = glm::vec3(Block::WALL_THICKNESS, Block::WALL_HEIGHT, Block::SIZE);
-
-        block.rightWall.pos = center + right * (halfSize + Block::WALL_THICKNESS * 0.5f)
-            + glm::vec3(0.0f, Block::WALL_HEIGHT * 0.5f, 0.0f);
-        block.rightWall.size = glm::vec3(Block::WALL_THICKNESS, Block::WALL_HEIGHT, Block::SIZE);
-
-        block.hasFrontWall = false;
-    }
-    else if (type == BlockType::TurnLeft) {
-        block.hasFrontWall = true;
-        block.frontWall.pos = center + forward * (halfSize + Block::WALL_THICKNESS * 0.5f)
-            + glm::vec3(0.0f, Block::WALL_HEIGHT * 0.5f, 0.0f);
-        block.frontWall.size = glm::vec3(Block::SIZE + Block::WALL_THICKNESS * 2.0f, Block::WALL_HEIGHT, Block::WALL_THICKNESS);
-
-        block.rightWall.pos = center + right * (halfSize + Block::WALL_THICKNESS * 0.5f)
-            + glm::vec3(0.0f, Block::WALL_HEIGHT * 0.5f, 0.0f);
-        block.rightWall.size = glm::vec3(Block::WALL_THICKNESS, Block::WALL_HEIGHT, Block::SIZE);
-
-        // No left wall
-        block.leftWall.size = glm::vec3(0.0f);
-    }
-    else if (type == BlockType::TurnRight) {
-        block.hasFrontWall = true;
-        block.frontWall.pos = center + forward * (halfSize + Block::WALL_THICKNESS * 0.5f)
-            + glm::vec3(0.0f, Block::WALL_HEIGHT * 0.5f, 0.0f);
-        block.frontWall.size = glm::vec3(Block::SIZE + Block::WALL_THICKNESS * 2.0f, Block::WALL_HEIGHT, Block::WALL_THICKNESS);
-
-        block.leftWall.pos = center - right * (halfSize + Block::WALL_THICKNESS * 0.5f)
-            + glm::vec3(0.0f, Block::WALL_HEIGHT * 0.5f, 0.0f);
-        block.leftWall.size = glm::vec3(Block::WALL_THICKNESS, Block::WALL_HEIGHT, Block::SIZE);
-
-        // No right wall
-        block.rightWall.size = glm::vec3(0.0f);
-    }
-
-    // Rotate wall sizes based on yaw for proper collision
-    if (std::abs(std::fmod(yaw, 180.0f) - 90.0f) < 1.0f || std::abs(std::fmod(yaw, 180.0f) + 90.0f) < 1.0f) {
-        std::swap(block.leftWall.size.x, block.leftWall.size.z);
-        std::swap(block.rightWall.size.x, block.rightWall.size.z);
-        if (block.hasFrontWall) {
-            std::swap(block.frontWall.size.x, block.frontWall.size.z);
-        }
-    }
-
-    return block;
+static void pushCustomItem(RenderPass pass, unsigned int program, RenderCustomFn fn, float depth) {
+    RenderItem item;
+    item.pass = pass;
+    item.program = program;
+    item.custom = fn;
+    gRenderQueue.push(item, depth);
 }
 
-void generateNextBlock() {
-    BlockType type = BlockType::Normal;
-    bool shouldHaveObstacle = false;
-
-    // Every 20th block (20, 40, 60...) is a turn block
-    if (gNextBlockIndex > 0 && gNextBlockIndex % 20 == 0) {
-        float r = frand01();
-        if (r < 0.33f) {
-            type = BlockType::TurnStraight;
+// Walks the sorted queue and only rebinds what changed. With depthOnly set the opaque
+// items are drawn with color writes off to fill the depth buffer (pre-pass).
+static void submitQueue(bool depthOnly) {
+    RenderStats& stats = gRenderQueue.stats;
+    unsigned int curProgram = 0, curTexture = 0, curVAO = 0;
+    long long curObject = -1;
+
+    for (const RenderItem& item : gRenderQueue.list()) {
+        if (depthOnly && item.pass != RenderPass::Opaque) break;
+
+        if (item.custom) {
+            item.custom(item);
+            // custom items bind their own state
+            curProgram = curTexture = curVAO = 0;
+            curObject = -1;
+            stats.drawCalls++;
+            if (depthOnly) stats.prepassDraws++;
+            continue;
         }
-        else if (r < 0.66f) {
-            type = BlockType::TurnLeft;
+        if (item.program != curProgram) {
+            glUseProgram(item.program);
+            curProgram = item.program;
+            stats.programBinds++;
         }
-        else {
-            type = BlockType::TurnRight;
+        if (item.texture != curTexture) {
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, item.texture);
+            curTexture = item.texture;
+            stats.textureBinds++;
+        }
+        if (item.vao != curVAO) {
+            glBindVertexArray(item.vao);
+            curVAO = item.vao;
+            stats.vaoBinds++;
         }
+        if (item.objectOffset >= 0 && item.objectOffset != curObject) {
+            glBindBufferRange(GL_UNIFORM_BUFFER, UBO_OBJECT, gStream.id(), (GLintptr)item.objectOffset, (GLsizeiptr)item.objectSize);
+            curObject = item.objectOffset;
+            stats.objectBinds++;
+        }
+        glDrawElements(GL_TRIANGLES, item.indexCount, GL_UNSIGNED_INT, 0);
+        stats.drawCalls++;
+        if (depthOnly) stats.prepassDraws++;
     }
-    // Every block where index % 4 == 1, starting from block 5 (5, 9, 13, 17...) has an obstacle
-    // But exclude blocks where %20 == 1 (21, 41, 61...) which are right after turns
-    else if (gNextBlockIndex >= 5 && gNextBlockIndex % 4 == 1 && gNextBlockIndex % 20 != 1) {
-        shouldHaveObstacle = true;
+    glBindVertexArray(0);
+}
+
+void executeRenderQueue() {
+    gRenderQueue.sort();
+    gRenderQueue.stats = RenderStats();
+    gRenderQueue.stats.items = (int)gRenderQueue.size();
+
+    if (gRenderQueue.depthPrepass) {
+        glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+        submitQueue(true);
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+        // depth is already final, color pass only shades the visible surface
+        glDepthMask(GL_FALSE);
+        submitQueue(false);
+        glDepthMask(GL_TRUE);
     }
+    else {
+        submitQueue(false);
+    }
+}
+
+// ------------- level rendering ------------------
+ShaderProgram* gAnimShader = nullptr;
+bool gUseLevelBatch = false;
+
+std::vector<LevelPiece> gLevelPieces;
+
+// Frame job for the GL 3.3 path: transforms and camera culling of every floor, wall and obstacle
+void cullBlocks(const CameraSnapshot& cam) {
+    gLevelPieces.clear();
+    if (gUseLevelBatch) return;
+    MeshDraw meshes[2];
+    meshes[LEVEL_MESH_FLOOR].texture = FloorTile::sharedTexture;
+    meshes[LEVEL_MESH_FLOOR].vao = gFloorTile.VAO;
+    meshes[LEVEL_MESH_FLOOR].indexCount = 6;
+    meshes[LEVEL_MESH_BOX].texture = gBox.texture;
+    meshes[LEVEL_MESH_BOX].vao = gBox.VAO;
+    meshes[LEVEL_MESH_BOX].indexCount = gBox.indexCount;
+    cullLevelPieces(gWorld, gDrawBlocksAhead, cam, meshes, gPieceVisible, gLevelPieces);
+}
 
-    Block block = createBlock(gNextBlockIndex, type, gNextBlockCenter, gCurrentBuildYaw);
+// GL 3.3 path: one queue item per visible piece
+void prepareBlocks() {
+    queueLevelPieces(gRenderQueue, gQueueEye, gAnimShader->ID, gLevelPieces,
+        [](const glm::mat4& model) { return streamModelMatrix(model); },
+        [](const MeshDraw& mesh, const StreamBuffer::Alloc& object) { addCaster(gLevelCasters, mesh, object); });
+}
 
-    // Add obstacle if needed
-    if (shouldHaveObstacle) {
-        block.hasObstacle = true;
-        ObsType obsType = (frand01() < 0.5f) ? ObsType::JumpWall : ObsType::SlideGate;
-        block.obstacle.type = obsType;
-        block.obstacle.pos = block.centerPos;
+// GPU-driven path: whole level in one glMultiDrawElementsIndirect (GL 4.3+)
+LevelBatch gLevelBatch;
+unsigned int gLevelBatchRevision = ~0u;
+ShaderProgram* gLevelShader = nullptr;
 
-        // Determine obstacle orientation based on block yaw
-        float blockYaw = gCurrentBuildYaw;
-        bool facingZ = (std::abs(std::fmod(blockYaw + 360.0f, 180.0f)) < 1.0f); // Facing +Z or -Z
+void rebuildLevelBatch() {
+    gLevelBatch.begin();
+    // a piece's occlusion group is its index in gPieceVisible
+    int piece = 0;
+    auto add = [&piece](LevelMesh mesh, const glm::vec3& pos, const glm::vec3& size) {
+        glm::mat4 M(1.0f);
+        M = glm::translate(M, pos);
+        M = glm::scale(M, size);
+        float texSlot = mesh == LEVEL_MESH_FLOOR ? 0.0f : 1.0f;
+        gLevelBatch.add((LevelBatch::Mesh)mesh, M, texSlot, pos - size * 0.5f, pos + size * 0.5f, piece++);
+        };
 
-        if (obsType == ObsType::JumpWall) {
-            if (facingZ) {
-                block.obstacle.size = glm::vec3(Block::SIZE, 0.6f, 0.7f);
-            }
-            else {
-                block.obstacle.size = glm::vec3(0.7f, 0.6f, Block::SIZE);
-            }
-            block.obstacle.pos.y = 0.3f;
-        }
-        else {
-            if (facingZ) {
-                block.obstacle.size = glm::vec3(Block::SIZE, 1.0f, 1.2f);
-            }
-            else {
-                block.obstacle.size = glm::vec3(1.2f, 1.0f, Block::SIZE);
-            }
-            block.obstacle.pos.y = 1.5f;
-        }
+    for (const auto& block : gWorld.blocks) {
+        if (!inDrawRange(block)) continue;
+        forEachLevelPiece(block, add);
     }
+    gLevelBatch.upload();
+    gLevelBatchRevision = gWorld.revision;
+}
 
-    // Generate coins for blocks where index % 10 == 2,3,4,5,6
-    int blockMod10 = gNextBlockIndex % 10;
-    if (blockMod10 >= 2 && blockMod10 <= 6) {
-        glm::vec3 forward = getDirectionFromYaw(gCurrentBuildYaw);
-        glm::vec3 right = getRightFromYaw(gCurrentBuildYaw);
+// Runs before the queue is submitted so the pre-pass and color pass see the same commands
+void cullLevelBatch(const glm::vec4 frustumPlanes[6]) {
+    if (gLevelBatchRevision != gWorld.revision) rebuildLevelBatch();
+    gLevelBatch.cull(frustumPlanes, gPieceVisible.data(), (int)gPieceVisible.size());
+}
 
-        // At block %10 == 2, start a new coin pattern
-        if (blockMod10 == 2) {
-            gCoinOnLeftSide = (frand01() < 0.5f);
-            gCoinSwitchAtBlock4 = false;
-        }
+static void drawLevelBatchItem(const RenderItem& /*item*/) {
+    gLevelShader->use();
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, FloorTile::sharedTexture);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, gBox.texture);
+    gLevelBatch.draw();
+    glActiveTexture(GL_TEXTURE0);
+}
 
-        // At block %10 == 4, 50% chance to switch sides
-        if (blockMod10 == 4) {
-            gCoinSwitchAtBlock4 = (frand01() < 0.5f);
-        }
+void prepareLevel() {
+    if (gUseLevelBatch) pushCustomItem(RenderPass::Opaque, gLevelShader->ID, drawLevelBatchItem, 0.0f);
+    else prepareBlocks();
+}
 
-        float leftPos = -1.0f;   // Position 1
-        float rightPos = 1.0f;   // Position 4
+Model* gCoinModel = nullptr;
+ShaderProgram* gStaticShader = nullptr;
+
+// ------------- coin LODs ------------------
+ModelLod gCoinLod;
+ShaderProgram* gImpostorShader = nullptr;
+unsigned int gImpostorVAO = 0;
+
+std::vector<glm::vec4> gCoinImpostors;    // xyz = center, w = radius
+StreamBuffer::Alloc gCoinImpostorAlloc;
+
+// Far coins: one instanced draw of camera-facing discs sourced straight from the ring buffer
+static void drawCoinImpostorsItem(const RenderItem& /*item*/) {
+    gImpostorShader->use();
+    glBindVertexArray(gImpostorVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, gStream.id());
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), (void*)gCoinImpostorAlloc.offset);
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (GLsizei)gCoinImpostors.size());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+}
 
-        // Determine current side based on pattern
-        bool currentlyOnLeft = gCoinOnLeftSide;
-        if (gCoinSwitchAtBlock4 && blockMod10 >= 5) {
-            currentlyOnLeft = !gCoinOnLeftSide;  // Switched sides after block 4
-        }
+std::vector<CoinDraw> gCoinDraws;
 
-        float lateralOffset = currentlyOnLeft ? leftPos : rightPos;
+// Frame job: drops the coins outside the camera frustum or behind the walls
+// (a coin's shadow is too small to miss) and picks a LOD for the rest.
+void cullCoins(const CameraSnapshot& cam, float viewportHeight) {
+    gCoinDraws.clear();
+    gCoinImpostors.clear();
+    gCoinsOccluded = 0;
+    if (!gCoinModel || !gStaticShader) return;
+    gCoinsOccluded = cullCoinDraws(gWorld, gDrawBlocksAhead, cam, viewportHeight, gCoinLod,
+        gUseOcclusion ? &gOcclusion : nullptr, gCoinDraws, gCoinImpostors);
+}
 
-        // Generate 5 coins per block
-        for (int i = 0; i < 5; i++) {
-            Block::Coin coin;
+void prepareCoins() {
+    MeshDraw lodMeshes[ModelLod::MAX_LODS];
+    for (int i = 0; i < ModelLod::MAX_LODS; ++i) {
+        lodMeshes[i].vao = gCoinLod.vao(i);
+        lodMeshes[i].indexCount = gCoinLod.indexCount(i);
+    }
+    queueCoinDraws(gRenderQueue, gQueueEye, gStaticShader->ID, lodMeshes, gCoinDraws,
+        [](const glm::mat4& model) { return streamModelMatrix(model); },
+        [](const MeshDraw& mesh, const StreamBuffer::Alloc& object) { addCaster(gCoinCasters, mesh, object); });
+
+    gCoinImpostorAlloc = StreamBuffer::Alloc();
+    if (!gCoinImpostors.empty() && gImpostorShader) {
+        gCoinImpostorAlloc = gStream.write(gCoinImpostors.data(), sizeof(glm::vec4) * gCoinImpostors.size());
+        if (gCoinImpostorAlloc.valid())
+            pushCustomItem(RenderPass::Opaque, gImpostorShader->ID, drawCoinImpostorsItem, gRenderQueue.farPlane);
+    }
+}
 
-            // Position along forward direction: -2, -1, 0, +1, +2 within the block
-            float forwardOffset = (i - 2) * 0.8f;
+void initCoinImpostors() {
+    glGenVertexArrays(1, &gImpostorVAO);
+    glBindVertexArray(gImpostorVAO);
+    glEnableVertexAttribArray(0);
+    glVertexAttribDivisor(0, 1);
+    glBindVertexArray(0);
+}
 
-            bool isTransitionBlock = (blockMod10 == 4 && gCoinSwitchAtBlock4);
-            if (isTransitionBlock) {
-                float t = (i + 1) / 6.0f;
-                if (gCoinOnLeftSide) {
-                    //left to right
-                    lateralOffset = glm::mix(leftPos, rightPos, t);
-                }
-                else {
-                    //right to left
-                    lateralOffset = glm::mix(rightPos, leftPos, t);
-                }
-            }
+// ------------- player ------------------
+// One item per mesh; anim_model.fs only samples the diffuse map so that is the one bound.
+void preparePlayer(Model& playerModel, const StreamBuffer::Alloc& object) {
+    if (!object.valid()) return;
+    for (const auto& mesh : playerModel.meshes) {
+        unsigned int diffuse = 0;
+        for (const auto& tex : mesh.textures) {
+            if (tex.type == "texture_diffuse") { diffuse = tex.id; break; }
+        }
+        pushMeshItem(RenderPass::Opaque, gAnimShader->ID, diffuse, mesh.VAO, (int)mesh.indices.size(), object, gWorld.player.pos);
+        gPlayerCasters.push_back({ mesh.VAO, (int)mesh.indices.size(), object });
+    }
+}
 
-            coin.pos = block.centerPos + right * lateralOffset + forward * forwardOffset;
-            coin.pos.y = 1.0f;
+// ------------- sky ------------------
+Skybox gSkybox;
+ShaderProgram* gSkyboxShader = nullptr;
+glm::mat4 gSkyInvViewProj(1.0f);
 
-            // If this block has a jump obstacle
-            if (block.hasObstacle && block.obstacle.type == ObsType::JumpWall) {
-                if (i == 1) {
-                    coin.pos.y = 1.4f;
-                }
-                else if (i == 2) {
-                    coin.pos.y = 1.8f;
-                }
-                else if (i == 3) {
-                    coin.pos.y = 1.4f;
-                }
-            }
+static void drawSkyItem(const RenderItem& /*item*/) {
+    gSkybox.draw(gSkyboxShader->ID, gSkyInvViewProj);
+}
 
-            coin.collected = false;
-            coin.rotation = 0.0f;
+void prepareSky(const CameraSnapshot& cam) {
+    if (!gSkyboxShader || !gSkybox.ready()) return;
+    gSkyInvViewProj = glm::inverse(cam.projection * glm::mat4(glm::mat3(cam.view)));
+    pushCustomItem(RenderPass::Sky, gSkyboxShader->ID, drawSkyItem, 0.0f);
+}
 
-            block.coins.push_back(coin);
-        }
-    }
+// ------------- run log ------------------
+// Every run's events, speed and frame times go to a memory-mapped file (run_log.h) instead of
+// the console; tools/run_stats.cpp aggregates logs.
+RunLog gRunLog;
+uint16_t gRunLogFlags = 0;                 // replay / fixed-step marks for this session's runs
+const float RUN_LOG_SPEED_INTERVAL = 0.25f;   // run seconds between speed samples
+float gRunLogNextSpeed = 0.0f;
+
+static void beginRunLog() {
+    gRunLog.beginRun((float)LEVEL_SEED, gRunLogFlags);
+    gRunLogNextSpeed = 0.0f;
+}
 
-    gBlocks.push_back(block);
+// This frame's collisions (before emitWorldEvents drains them) and the periodic speed sample.
+static void logWorldEvents() {
+    if (!gRunLog.running()) return;
+    for (int i = 0; i < gWorld.eventCount; ++i) {
+        const WorldEvent& e = gWorld.events[i];
+        RunLogType type = e.type == WorldEventType::CoinPickup ? RunLogType::Coin : RunLogType::Hit;
+        gRunLog.append(type, gWorld.time, e.pos.x, e.pos.y, e.pos.z);
+    }
+    if (gWorld.time >= gRunLogNextSpeed) {
+        gRunLog.append(RunLogType::Speed, gWorld.time, gWorld.speed, (float)gWorld.playerBlock, (float)gWorld.coinCount);
+        gRunLogNextSpeed = gWorld.time + RUN_LOG_SPEED_INTERVAL;
+    }
+}
 
-    // Calculate next block position
-    glm::vec3 forward = getDirectionFromYaw(gCurrentBuildYaw);
-    gNextBlockCenter += forward * Block::SIZE;
+// ------------- particles ------------------
+ParticleSystem gParticles;
+ShaderProgram* gParticleShader = nullptr;
 
-    // Update build direction if this was a turn block
-    if (type == BlockType::TurnLeft) {
-        gCurrentBuildYaw += 90.0f;
-        if (gCurrentBuildYaw >= 360.0f) gCurrentBuildYaw -= 360.0f;
-        // Adjust next center for the turn
-        gNextBlockCenter = block.centerPos + getRightFromYaw(block.yaw) * (-Block::SIZE);
-    }
-    else if (type == BlockType::TurnRight) {
-        gCurrentBuildYaw -= 90.0f;
-        if (gCurrentBuildYaw < 0.0f) gCurrentBuildYaw += 360.0f;
-        // Adjust next center for the turn
-        gNextBlockCenter = block.centerPos + getRightFromYaw(block.yaw) * Block::SIZE;
+// One burst per collision of this frame's steps; the particles themselves never leave the GPU.
+static void emitWorldEvents() {
+    for (int i = 0; i < gWorld.eventCount; ++i) {
+        const WorldEvent& e = gWorld.events[i];
+        if (e.type == WorldEventType::CoinPickup) gParticles.emit(e.pos, PARTICLE_SPARKLE, 48);
+        else gParticles.emit(e.pos, PARTICLE_IMPACT, 160);
     }
+    gWorld.clearEvents();
+}
 
-    gNextBlockIndex++;
+static void drawParticlesItem(const RenderItem& /*item*/) {
+    gParticles.draw(gParticleShader->ID);
 }
 
-void updateBlockGeneration() {
-    // Calculate how far ahead we need to generate (50 blocks)
-    const int BLOCKS_AHEAD = 50;
-
-    // Find the block the player is currently in
-    int playerBlockIndex = -1;
-    for (const auto& block : gBlocks) {
-        glm::vec3 toPlayer = player.pos - block.centerPos;
-        float distSq = toPlayer.x * toPlayer.x + toPlayer.z * toPlayer.z;
-        if (distSq < Block::SIZE * Block::SIZE) {
-            playerBlockIndex = block.blockIndex;
-            break;
-        }
+// Advances the simulation (a compute dispatch or a transform feedback pass) and queues the
+// draw after the sky, as long as any particle is alive.
+void prepareParticles(float dt) {
+    if (!gParticleShader || !gParticles.ready()) return;
+    gParticles.update(dt);
+    if (gParticles.active())
+        pushCustomItem(RenderPass::Transparent, gParticleShader->ID, drawParticlesItem, 0.0f);
+}
+
+// ------------- shadows ------------------
+ShadowCascades gShadows;
+ShaderProgram* gShadowLevelShader = nullptr;    // level.vs + shadow_depth.fs
+ShaderProgram* gShadowAnimShader = nullptr;     // anim_model.vs + shadow_depth.fs
+ShaderProgram* gShadowStaticShader = nullptr;   // static_model.vs + shadow_depth.fs
+StreamBuffer::Alloc gShadowFrames[ShadowCascades::CASCADES];
+unsigned int gShadowDirty = 0;
+
+// Light matrices go through the same FrameData block, so the regular vertex shaders
+// render the casters. Returns the ShadowData range the lit shaders read.
+StreamBuffer::Alloc prepareShadows(const CameraSnapshot& cam) {
+    gShadowDirty |= gShadows.update(cam.view, cam.lens.fovY, cam.lens.aspect, cam.lens.zNear, gWorld.revision);
+
+    ShadowDataStd140 shadowData;
+    for (int c = 0; c < ShadowCascades::CASCADES; ++c) {
+        FrameDataStd140 lightFrame;
+        lightFrame.projection = gShadows.lightProj(c);
+        lightFrame.view = gShadows.lightView(c);
+        lightFrame.viewPos = glm::vec4(cam.position, 1.0f);
+        lightFrame.lightPos = glm::vec4(-gShadows.direction(), 0.0f);
+        gShadowFrames[c] = gStream.write(&lightFrame, sizeof(lightFrame));
+
+        shadowData.lightViewProj[c] = lightFrame.projection * lightFrame.view;
+        shadowData.cascadeTexel[c] = gShadows.texelSize(c);
     }
+    shadowData.cascadeSplits = glm::vec4(gShadows.splits[0], gShadows.splits[1], gShadows.splits[2],
+        gShadows.splits[2] - gShadows.fadeRange);
+    shadowData.sunDirection = glm::vec4(gShadows.direction(), 0.0f);
+    shadowData.sunColor = glm::vec4(1.0f, 0.96f, 0.88f, 0.35f);
+    return gStream.write(&shadowData, sizeof(shadowData));
+}
 
-    // Generate blocks ahead
-    while (gNextBlockIndex < playerBlockIndex + BLOCKS_AHEAD) {
-        generateNextBlock();
+static void drawCasters(const ShaderProgram* shader, const std::vector<ShadowCaster>& casters) {
+    if (!shader || casters.empty()) return;
+    shader->use();
+    for (const auto& caster : casters) {
+        gStream.bindRange(UBO_OBJECT, caster.object);
+        glBindVertexArray(caster.vao);
+        glDrawElements(GL_TRIANGLES, caster.indexCount, GL_UNSIGNED_INT, 0);
     }
+    glBindVertexArray(0);
+}
 
-    // Remove blocks far behind (keep last 10)
-    while (gBlocks.size() > 60 && !gBlocks.empty()) {
-        if (gBlocks.front().blockIndex < playerBlockIndex - 10) {
-            gBlocks.pop_front();
+// Static layers only when the level or a cascade box changed; dynamic layers every frame.
+void renderShadows() {
+    glEnable(GL_POLYGON_OFFSET_FILL);
+    glPolygonOffset(1.5f, 2.0f);
+
+    if (gShadowDirty && gUseLevelBatch && gLevelBatchRevision != gWorld.revision) rebuildLevelBatch();
+    for (int c = 0; c < ShadowCascades::CASCADES; ++c) {
+        if (!(gShadowDirty & (1u << c)) || !gShadowFrames[c].valid()) continue;
+        gShadows.beginStatic(c);
+        gStream.bindRange(UBO_FRAME, gShadowFrames[c]);
+        if (gUseLevelBatch) {
+            // cull against the cascade box; the camera cull later in the frame overwrites it
+            glm::vec4 planes[6];
+            ExtractFrustumPlanes(gShadows.lightProj(c) * gShadows.lightView(c), planes);
+            gLevelBatch.cull(planes);
+            gShadowLevelShader->use();
+            gLevelBatch.draw();
         }
         else {
-            break;
+            drawCasters(gShadowAnimShader, gLevelCasters);
         }
+        gShadowDirty &= ~(1u << c);
     }
+
+    for (int c = 0; c < ShadowCascades::CASCADES; ++c) {
+        if (!gShadowFrames[c].valid()) continue;
+        gShadows.beginDynamic(c);
+        gStream.bindRange(UBO_FRAME, gShadowFrames[c]);
+        drawCasters(gShadowStaticShader, gCoinCasters);
+        drawCasters(gShadowAnimShader, gPlayerCasters);
+    }
+
+    glDisable(GL_POLYGON_OFFSET_FILL);
+    gSceneTarget->bind();
+    glActiveTexture(GL_TEXTURE0 + SHADOW_MAP_UNIT);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, gShadows.texture());
+    glActiveTexture(GL_TEXTURE0);
 }
 
-void drawBlocks(Shader& animShader) {
-    for (const auto& block : gBlocks) {
-        // Draw floor
-        gFloorTile.draw(animShader, block.centerPos, Block::SIZE);
+// ------------- point lights ------------------
+LightClusters gLightClusters;
+std::vector<PointLight> gLights;
+unsigned int gClusterListTexture = 0;   // R32UI view of the ring buffer
+
+// Integer view of the ring for cluster grids and index lists; light positions and colors
+// go through the RGBA32F view that also carries the bone palettes.
+void initLightClusters() {
+    GLint maxTexels = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+    if ((long long)maxTexels * 4 < (long long)gStream.totalSize())
+        std::cerr << "[Lights] ring buffer exceeds GL_MAX_TEXTURE_BUFFER_SIZE (" << maxTexels << " texels)\n";
+
+    glGenTextures(1, &gClusterListTexture);
+    glActiveTexture(GL_TEXTURE0 + CLUSTER_LIST_UNIT);
+    glBindTexture(GL_TEXTURE_BUFFER, gClusterListTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_R32UI, gStream.id());
+    glActiveTexture(GL_TEXTURE0);
+
+    gLightClusters.init(gJobs);
+}
 
-        // Draw walls
-        if (block.leftWall.size.x > 0.1f) {
-            gBox.draw(animShader, block.leftWall.pos, block.leftWall.size);
-        }
-        if (block.rightWall.size.x > 0.1f) {
-            gBox.draw(animShader, block.rightWall.pos, block.rightWall.size);
-        }
-        if (block.hasFrontWall) {
-            gBox.draw(animShader, block.frontWall.pos, block.frontWall.size);
+// Torches on alternating wall sides plus a small glow on every coin still in play.
+void gatherLights(float time) {
+    gLights.clear();
+    for (const auto& block : gWorld.blocks) {
+        if (!inDrawRange(block)) continue;
+        const Wall* wall = (block.blockIndex & 1) ? &block.rightWall : &block.leftWall;
+        if (wall->size.x > 0.1f) {
+            glm::vec3 inward = block.centerPos - wall->pos;
+            inward.y = 0.0f;
+            inward = glm::normalize(inward);
+            PointLight torch;
+            torch.pos = wall->pos + inward * (Block::WALL_THICKNESS * 0.5f + 0.3f) + glm::vec3(0.0f, 0.7f, 0.0f);
+            torch.radius = 7.0f;
+            float flicker = 0.85f + 0.15f * std::sin(time * 13.0f + block.blockIndex * 1.7f) * std::sin(time * 7.3f + block.blockIndex);
+            torch.color = glm::vec3(1.0f, 0.55f, 0.2f) * (2.5f * flicker);
+            gLights.push_back(torch);
         }
-
-        // Draw obstacle
-        if (block.hasObstacle) {
-            gBox.draw(animShader, block.obstacle.pos, block.obstacle.size);
+        for (const auto& coin : block.coins) {
+            if (coin.collected) continue;
+            PointLight glow;
+            glow.pos = coin.pos + gCoinLod.center;
+            glow.radius = 2.0f;
+            glow.color = glm::vec3(1.0f, 0.8f, 0.25f) * 0.6f;
+            gLights.push_back(glow);
         }
     }
 }
 
-Model* gCoinModel = nullptr;
-Shader* gStaticShader = nullptr;
-Model* gEnvironmentModel = nullptr;
-unsigned int gSkyboxTexture = 0;
-
-void drawCoins(Shader& animShader, const glm::mat4& projection, const glm::mat4& view) {
-    if (!gCoinModel || !gStaticShader) return;
-
-    gStaticShader->use();
-    gStaticShader->setMat4("projection", projection);
-    gStaticShader->setMat4("view", view);
-
-    // Set lighting uniforms
-    gStaticShader->setBool("useLighting", true);
-    gStaticShader->setBool("useTexture", false);
-    gStaticShader->setVec3("objectColor", glm::vec3(1.0f, 0.84f, 0.0f));
-    gStaticShader->setVec3("lightColor", glm::vec3(1.0f, 1.0f, 1.0f));
-    gStaticShader->setVec3("lightPos", camPos + glm::vec3(0.0f, 5.0f, 0.0f));
-    gStaticShader->setVec3("viewPos", camPos);
-
-    for (auto& block : gBlocks) {
-        for (auto& coin : block.coins) {
-            if (coin.collected) continue;
+struct ClusterDataStd140 {
+    glm::vec4 params;   // xy = tiles per pixel, z = slice scale, w = first slice depth
+    glm::vec4 range;    // x = last slice depth
+    glm::ivec4 dims;
+    glm::ivec4 bases;   // texel offsets: lights (RGBA32F), grid and indices (R32UI)
+};
 
-            // coin rotation
-            coin.rotation += 2.0f * deltaTime;
+// Frame job: collects this frame's lights and bins them, one nested job per depth slice.
+void binLights(const CameraSnapshot& cam) {
+    gatherLights(gClock);
+    gLightClusters.build(gLights, cam.view, cam.lens.fovY, cam.lens.aspect);
+}
 
-            glm::mat4 coinModelMat = glm::mat4(1.0f);
-            coinModelMat = glm::translate(coinModelMat, coin.pos);
-            coinModelMat = glm::rotate(coinModelMat, coin.rotation, glm::vec3(0, 1, 0));
-            coinModelMat = glm::scale(coinModelMat, glm::vec3(1.0f));
-            gStaticShader->setMat4("model", coinModelMat);
-            gCoinModel->Draw(*gStaticShader);
+// Streams the light, grid and index lists binned by binLights() into the ring.
+StreamBuffer::Alloc prepareLights() {
+    StreamBuffer::Alloc lightAlloc = gStream.allocate(std::max<size_t>(gLights.size(), 1) * 2 * sizeof(glm::vec4));
+    if (lightAlloc.valid()) {
+        glm::vec4* dst = (glm::vec4*)lightAlloc.ptr;
+        for (const auto& light : gLights) {
+            *dst++ = glm::vec4(light.pos, light.radius);
+            *dst++ = glm::vec4(light.color, 0.0f);
         }
     }
-    animShader.use();
+    const auto& grid = gLightClusters.gridData();
+    const auto& indices = gLightClusters.indexData();
+    StreamBuffer::Alloc gridAlloc = gStream.write(grid.data(), grid.size() * sizeof(uint32_t));
+    StreamBuffer::Alloc indexAlloc = gStream.write(indices.data(), std::max<size_t>(indices.size(), 1) * sizeof(uint32_t));
+    if (!lightAlloc.valid() || !gridAlloc.valid() || !indexAlloc.valid()) return StreamBuffer::Alloc();
+
+    ClusterDataStd140 cluster;
+    cluster.params = glm::vec4((float)LightClusters::TILES_X / (float)gSceneTarget->getWidth(), (float)LightClusters::TILES_Y / (float)gSceneTarget->getHeight(),
+        gLightClusters.sliceScale(), gLightClusters.zNear);
+    cluster.range = glm::vec4(gLightClusters.zFar, 0.0f, 0.0f, 0.0f);
+    cluster.dims = glm::ivec4(LightClusters::TILES_X, LightClusters::TILES_Y, LightClusters::SLICES, 0);
+    cluster.bases = glm::ivec4((int)(lightAlloc.offset / 16), (int)(gridAlloc.offset / 4), (int)(indexAlloc.offset / 4), (int)gLights.size());
+    return gStream.write(&cluster, sizeof(cluster));
 }
 
-void drawEnvironment(const glm::mat4& projection, const glm::mat4& view) {
-    if (!gEnvironmentModel || !gStaticShader) return;
-
-    glDepthFunc(GL_LEQUAL);
-    glDisable(GL_CULL_FACE);
-
-    gStaticShader->use();
-    gStaticShader->setMat4("projection", projection);
-
-    glm::mat4 skyboxView = glm::mat4(glm::mat3(view));
-    gStaticShader->setMat4("view", skyboxView);
+// ------------- game over screen ------------------
+GameOverScreen gGameOverScreen;
+float gGameOverStart = 0.0f;           // gClock when the run ended
+const float GAME_OVER_FADE = 0.6f;     // seconds for the post-effect to settle
 
-    gStaticShader->setBool("useLighting", false);
-
-    if (gSkyboxTexture != 0) {
-        gStaticShader->setBool("useTexture", true);
-        gStaticShader->setInt("texture_diffuse1", 0);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, gSkyboxTexture);
-    }
-    else {
-        gStaticShader->setBool("useTexture", false);
-    }
-    gStaticShader->setVec3("objectColor", glm::vec3(0.5f, 0.7f, 1.0f));
+// ------------- reset game ------------------
+static void ResetAll(GLFWwindow* window, Animator& animator, Animation& runAnim) {
+    glfwSetWindowTitle(window, "Temple Run - HP: 1 | Coins: 0 | Speed: 1.00x");
 
-    glm::mat4 envModelMat = glm::mat4(1.0f);
-    envModelMat = glm::rotate(envModelMat, glm::radians(90.0f), glm::vec3(-1.0f, 0.0f, 0.0f));
-    envModelMat = glm::scale(envModelMat, glm::vec3(500.0f));  // scale very big
+    gWorld.restartFrom(gWorldStart);
+    beginRunLog();
+    gGameOverScreen.release();
+    gParticles.clear();
 
-    gStaticShader->setMat4("model", envModelMat);
-    gEnvironmentModel->Draw(*gStaticShader);
+    animator.PlayAnimation(&runAnim);
 
-    glDepthFunc(GL_LESS);
-    glEnable(GL_CULL_FACE);
+    gCameraRig.reset(glm::vec3(0.0f, 3.0f, 6.5f), glm::vec3(0.0f, 1.2f, -4.0f), 180.0f);
 }
 
-void checkCoinCollisions() {
-    glm::vec3 pmin, pmax;
-    player.getAABB(pmin, pmax);
-
-    for (auto& block : gBlocks) {
-        for (auto& coin : block.coins) {
-            if (coin.collected) continue;
-
-            const float coinRadius = 0.5f;
-            glm::vec3 cmin = coin.pos - glm::vec3(coinRadius);
-            glm::vec3 cmax = coin.pos + glm::vec3(coinRadius);
+// ------------- frame rendering ------------------
+// Everything the frame needs is written into the ring buffer once and every draw is
+// recorded into the render queue; the queue is then sorted by state and submitted.
+// The frame's jobs (animation, camera, culling, light binning) run while this thread
+// waits for the ring buffer; only then is their output streamed and queued.
+static void renderFrame(TaskGraph& frameJobs, Model& playerModel, const std::vector<glm::mat4>& playerBones, float dt) {
+    MemoryScope memory(MemTag::Render);
+    gStream.beginFrame();
+    frameJobs.wait();
+    const CameraSnapshot& cam = gCamera;
+
+    FrameDataStd140 frameData;
+    frameData.projection = cam.projection;
+    frameData.view = cam.view;
+    frameData.viewPos = glm::vec4(cam.position, 1.0f);
+    frameData.lightPos = glm::vec4(cam.position + glm::vec3(0.0f, 5.0f, 0.0f), 1.0f);
+    StreamBuffer::Alloc frameAlloc = gStream.write(&frameData, sizeof(frameData));
+
+    gRenderQueue.clear();
+    gQueueEye = cam.position;
+    gLevelCasters.clear();
+    gCoinCasters.clear();
+    gPlayerCasters.clear();
+    StreamBuffer::Alloc shadowAlloc = prepareShadows(cam);
+    StreamBuffer::Alloc clusterAlloc = prepareLights();
+    prepareLevel();
+    prepareCoins();
+
+    glm::mat4 model = glm::mat4(1.0f);
+    model = glm::translate(model, gWorld.player.pos);
+    model = glm::rotate(model, glm::radians(gWorld.player.yaw), glm::vec3(0, 1, 0));
+    model = glm::scale(model, glm::vec3(gWorld.player.scale));
+    StreamBuffer::Alloc playerObject = streamModelMatrix(model, streamBones(playerBones));
+    preparePlayer(playerModel, playerObject);
+
+    // Sky sorts after every opaque item: only pixels the level left at the far plane get shaded
+    prepareSky(cam);
+    prepareParticles(dt);
+
+    gStream.flush();
+    renderShadows();
+    gStream.bindRange(UBO_FRAME, frameAlloc);
+    gStream.bindRange(UBO_SHADOW, shadowAlloc);
+    gStream.bindRange(UBO_CLUSTER, clusterAlloc);
+
+    if (gUseLevelBatch) cullLevelBatch(cam.frustumPlanes);
+    executeRenderQueue();
+
+    gStream.endFrame();
+}
 
-            if (AABBIntersect(pmin, pmax, cmin, cmax)) {
-                coin.collected = true;
-                gCoinCount++;
-            }
-        }
+// ------------- quality governor ------------------
+QualityGovernor gQuality;
+GpuFrameTimer gGpuTimer;
+
+// Changes happen mid-run, so they go to the run log rather than the console.
+void applyQuality(const QualitySettings& q) {
+    if (gViewport.setScale(q.renderScale))
+        gRunLog.append(RunLogType::RenderScale, gWorld.time, gViewport.renderScale(),
+            (float)gViewport.sceneWidth(), (float)gViewport.sceneHeight());
+    gCoinLod.lodBias = q.coinLodBias;
+    if (q.drawBlocks != gDrawBlocksAhead) {
+        gDrawBlocksAhead = q.drawBlocks;
+        gWorld.revision++;   // level batch and static shadow layers hold the old range
     }
+    if (q.shadowResolution != gShadows.size()) gShadows.resize(q.shadowResolution);
 }
 
-void checkBlockCollisions() {
-    glm::vec3 pmin, pmax;
-    player.getAABB(pmin, pmax);
-
-    for (auto& block : gBlocks) {
-        // Check wall collisions
-        auto checkWall = [&](const Wall& w) {
-            if (w.size.x < 0.1f && w.size.z < 0.1f) return;
-            glm::vec3 wmin = w.pos - w.size * 0.5f;
-            glm::vec3 wmax = w.pos + w.size * 0.5f;
-
-            player.getAABB(pmin, pmax);
-
-            if (AABBIntersect(pmin, pmax, wmin, wmax)) {
-                // Calculate overlap on each axis
-                float overlapX1 = wmax.x - pmin.x;
-                float overlapX2 = pmax.x - wmin.x;
-                float overlapZ1 = wmax.z - pmin.z;
-                float overlapZ2 = pmax.z - wmin.z;
-
-                float minOverlapX = (overlapX1 < overlapX2) ? overlapX1 : -overlapX2;
-                float minOverlapZ = (overlapZ1 < overlapZ2) ? overlapZ1 : -overlapZ2;
+// ------------- launch options ------------------
+struct LaunchOptions {
+    bool headless = false;        // offscreen context (OSMesa / EGL surfaceless), no window system needed
+    int width = SCR_WIDTH;
+    int height = SCR_HEIGHT;
+    std::string recordPath;       // write this run's inputs on exit
+    std::string replayPath;       // drive the run from a recording instead of the keyboard
+    int benchFrames = 0;          // > 0: render this many frames, report ms/frame and exit
+    std::string captureDir;       // PNG readback destination
+    int captureEvery = 0;         // > 0: write every Nth frame into captureDir
+    std::string streamConfig = "streaming.cfg";   // level streaming window, see level_stream.h
+    int jobThreads = 0;           // job system threads including the main thread, 0 = one per core
+    bool watchShaders = false;    // rebuild shader programs whose source files change
+    bool occlusion = true;        // CPU occlusion culling behind the corridor walls
+    long long allocBudget = -1;   // >= 0: fail the run if a frame past warmup allocates more often
+    int heapBudgetMB = 0;         // > 0: fail the run if the heap ever grows past this
+    std::string assetDir;         // models and textures, empty = $TR_ASSETS or the working directory
+    std::string runLogPath = "runs.trlog";   // append-only run log, empty = off
+};
 
-                if (std::abs(minOverlapX) < std::abs(minOverlapZ)) {
-                    player.pos.x += minOverlapX;
-                }
-                else {
-                    player.pos.z += minOverlapZ;
-                }
-                player.getAABB(pmin, pmax);
-            }
-            };
+static void printUsage(const char* exe) {
+    std::cout << "usage: " << exe << " [options]\n"
+        "  --headless           render offscreen without a window (OSMesa/EGL, e.g. llvmpipe)\n"
+        "  --assets DIR         load models and textures from DIR (default $TR_ASSETS, else .)\n"
+        "  --size WxH           framebuffer size (default 1280x720)\n"
+        "  --record FILE        record this run's inputs\n"
+        "  --replay FILE        replay recorded inputs\n"
+        "  --bench N            render N frames, print ms/frame and exit\n"
+        "  --capture DIR        write frames as PNG into DIR\n"
+        "  --capture-every N    capture every Nth frame (default 1 with --capture)\n"
+        "  --stream-config FILE level streaming window and memory budget (default streaming.cfg)\n"
+        "  --jobs N             run frame jobs on N threads including the main one (default: all cores)\n"
+        "  --watch-shaders      reload shaders when their source files change\n"
+        "  --no-occlusion       draw what is hidden behind the walls too (for comparison)\n"
+        "  --alloc-budget N     exit with an error if a frame makes more than N heap allocations\n"
+        "  --heap-budget MB     exit with an error if the heap peaks above MB megabytes\n"
+        "  --run-log FILE       append runs to FILE (default runs.trlog)\n"
+        "  --no-run-log         do not keep a run log\n";
+}
 
-        checkWall(block.leftWall);
-        checkWall(block.rightWall);
-        if (block.hasFrontWall) {
-            checkWall(block.frontWall);
+static bool parseOptions(int argc, char** argv, LaunchOptions& opt) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--headless") opt.headless = true;
+        else if (arg == "--size" && hasValue) {
+            if (std::sscanf(argv[++i], "%dx%d", &opt.width, &opt.height) != 2 || opt.width <= 0 || opt.height <= 0) return false;
         }
-
-        // Check obstacle collision
-        if (block.hasObstacle && !block.obstacle.hit) {
-            glm::vec3 omin, omax;
-            block.obstacle.getAABB(omin, omax);
-
-            bool shouldBlock = true;
-            if (block.obstacle.type == ObsType::SlideGate) {
-                float barBottom = omin.y;
-                float playerTop = pmax.y;
-                if (player.sliding && playerTop <= barBottom + 0.01f) {
-                    shouldBlock = false;
-                }
-            }
-            if (block.obstacle.type == ObsType::JumpWall) {
-                float wallTop = omax.y;
-                if (!player.onGround && player.pos.y > wallTop + 0.01f) {
-                    shouldBlock = false;
-                }
-            }
-
-            if (AABBIntersect(pmin, pmax, omin, omax)) {
-                if (shouldBlock) {
-                    block.obstacle.hit = true;
-                    gHP -= 1;
-                    if (gHP <= 0) {
-                        gGameOver = true;
-                        glfwSetWindowTitle(glfwGetCurrentContext(), "GAME OVER - Press R to Restart");
-                    }
-
-                    // Push player out
-                    float dx1 = omax.x - pmin.x;
-                    float dx2 = pmax.x - omin.x;
-                    float dz1 = omax.z - pmin.z;
-                    float dz2 = pmax.z - omin.z;
-                    float pushX = (dx1 < dx2 ? -dx1 : dx2);
-                    float pushZ = (dz1 < dz2 ? -dz1 : dz2);
-
-                    if (std::abs(pushZ) <= std::abs(pushX)) {
-                        player.pos.z += pushZ + (pushZ > 0 ? 0.001f : -0.001f);
-                    }
-                    else {
-                        player.pos.x += pushX + (pushX > 0 ? 0.001f : -0.001f);
-                    }
-
-                    player.getAABB(pmin, pmax);
-                }
-            }
+        else if (arg == "--record" && hasValue) opt.recordPath = argv[++i];
+        else if (arg == "--replay" && hasValue) opt.replayPath = argv[++i];
+        else if (arg == "--bench" && hasValue) opt.benchFrames = std::atoi(argv[++i]);
+        else if (arg == "--capture" && hasValue) opt.captureDir = argv[++i];
+        else if (arg == "--capture-every" && hasValue) opt.captureEvery = std::atoi(argv[++i]);
+        else if (arg == "--stream-config" && hasValue) opt.streamConfig = argv[++i];
+        else if (arg == "--assets" && hasValue) opt.assetDir = argv[++i];
+        else if (arg == "--watch-shaders") opt.watchShaders = true;
+        else if (arg == "--no-occlusion") opt.occlusion = false;
+        else if (arg == "--run-log" && hasValue) opt.runLogPath = argv[++i];
+        else if (arg == "--no-run-log") opt.runLogPath.clear();
+        else if (arg == "--alloc-budget" && hasValue) {
+            opt.allocBudget = std::atoll(argv[++i]);
+            if (opt.allocBudget < 0) return false;
+        }
+        else if (arg == "--heap-budget" && hasValue) {
+            opt.heapBudgetMB = std::atoi(argv[++i]);
+            if (opt.heapBudgetMB <= 0) return false;
         }
+        else if (arg == "--jobs" && hasValue) {
+            opt.jobThreads = std::atoi(argv[++i]);
+            if (opt.jobThreads <= 0) return false;
+        }
+        else return false;
     }
+    if (!opt.captureDir.empty() && opt.captureEvery <= 0) opt.captureEvery = 1;
+    return true;
 }
 
-// ------------- reset game ------------------
-static void ResetAll(GLFWwindow* window, Animator& animator, Animation& runAnim) {
-    gHP = 1;
-    gCoinCount = 0;
-    gGameOver = false;
-    gGameSpeed = 1.0f;  // Reset speed
-    gGameTime = 0.0f;   // Reset game time
-    glfwSetWindowTitle(window, "Temple Run - HP: 1 | Coins: 0 | Speed: 1.00x");
-
-    player = Player();
-    gBlocks.clear();
-
-    gRandState = 1234567u;
-    gNextBlockIndex = 0;
-    gNextBlockCenter = glm::vec3(0.0f, 0.0f, 0.0f);
-    gCurrentBuildYaw = 180.0f;
+static FrameInput pollFrameInput(float dt) {
+    return gInput.collect(glfwGetTime(), dt);
+}
 
-    // Generate initial blocks
-    for (int i = 0; i < 50; ++i) {
-        generateNextBlock();
+// Runs one frame of simulation in pieces split at the moments buttons were pressed, so a jump
+// or turn starts where it happened in the frame rather than at its start. lateral is a per-frame
+// rate (movement scales with the step's dt), so every piece gets all of it.
+static void stepWorld(const FrameInput& input, float dt, uint32_t pressed) {
+    MemoryScope memory(MemTag::World);
+    struct Press { float at; uint32_t button; } presses[4];
+    int count = 0;
+    const uint32_t order[4] = { INPUT_JUMP, INPUT_SLIDE, INPUT_LEFT, INPUT_RIGHT };
+    for (uint32_t button : order) {
+        if (!(pressed & button)) continue;
+        Press p = { std::min(input.pressAt[FrameInput::pressSlot(button)], dt), button };
+        int i = count++;
+        for (; i > 0 && presses[i - 1].at > p.at; --i) presses[i] = presses[i - 1];
+        presses[i] = p;
     }
 
-    animator.PlayAnimation(&runAnim);
-
-    camPos = glm::vec3(0.0f, 3.0f, 6.5f);
-    camTarget = glm::vec3(0.0f, 1.2f, -4.0f);
-    camYaw = 180.0f;
+    float t = 0.0f;
+    uint32_t due = 0;
+    for (int i = 0; i < count; ++i) {
+        if (presses[i].at > t) {
+            gWorld.step(presses[i].at - t, due, input.mouseDx);
+            t = presses[i].at;
+            due = 0;
+            if (gWorld.gameOver) return;
+        }
+        due |= presses[i].button;
+    }
+    gWorld.step(dt - t, due, input.mouseDx);
 }
 
 // ------------- main ------------------
-int main() {
+int main(int argc, char** argv) {
+    LaunchOptions opt;
+    if (!parseOptions(argc, argv, opt)) {
+        printUsage(argv[0]);
+        return -1;
+    }
+
+    InputRecording replay, recording;
+    if (!opt.replayPath.empty() && !replay.load(opt.replayPath)) return -1;
+
+    // the model loader aborts on a missing file, so check before creating a context
+    if (!opt.assetDir.empty()) gAssetDir = opt.assetDir;
+    else if (const char* dir = std::getenv("TR_ASSETS")) gAssetDir = dir;
+    const char* requiredAssets[] = { "Idle.dae", "Running.dae", "Jump.dae", "Running Slide.dae", "Chinese Coin.fbx" };
+    for (const char* name : requiredAssets) {
+        if (!std::ifstream(assetPath(name))) {
+            std::cerr << "[Assets] " << assetPath(name) << " not found; point --assets or TR_ASSETS at the directory holding the models\n";
+            return -1;
+        }
+    }
+
+    gWorld.streaming.config.load(opt.streamConfig);
+    gWorld.streaming.config.applyEnvironment();
+    gWorld.streaming.describe();
+    gWorld.blockBytes = blockFootprint;
+    gWorldStart.streaming.config = gWorld.streaming.config;
+    gWorldStart.blockBytes = blockFootprint;
+    gDrawBlocksAhead = gWorld.streaming.blocksAhead(Block::SIZE);
+
+    if (opt.headless) {
+#if GLFW_VERSION_MAJOR > 3 || (GLFW_VERSION_MAJOR == 3 && GLFW_VERSION_MINOR >= 4)
+        // null platform: no display server, the context comes from OSMesa or EGL surfaceless
+        glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+#else
+        std::cerr << "--headless needs GLFW 3.4 or newer\n";
+        return -1;
+#endif
+    }
     glfwInit();
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
@@ -1035,8 +1210,16 @@ int main() {
 #ifdef __APPLE__
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 #endif
+    if (opt.headless) {
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+        glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_OSMESA_CONTEXT_API);
+    }
 
-    GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Temple Run - HP: 1 | Coins: 0", nullptr, nullptr);
+    GLFWwindow* window = glfwCreateWindow(opt.width, opt.height, "Temple Run - HP: 1 | Coins: 0", nullptr, nullptr);
+    if (!window && opt.headless) {
+        glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_EGL_CONTEXT_API);
+        window = glfwCreateWindow(opt.width, opt.height, "Temple Run", nullptr, nullptr);
+    }
     if (!window) {
         std::cerr << "Failed to create window\n";
         glfwTerminate();
@@ -1045,200 +1228,408 @@ int main() {
     glfwMakeContextCurrent(window);
     glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
     glfwSetCursorPosCallback(window, mouse_callback);
+    glfwSetKeyCallback(window, key_callback);
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
 
     if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
         std::cerr << "Failed to init GLAD\n";
         return -1;
     }
-    glEnable(GL_DEPTH_TEST);
+    std::cout << "[GL] " << glGetString(GL_RENDERER) << " / " << glGetString(GL_VERSION) << std::endl;
+    gGpuMemory.install();
+    currentMemTag() = MemTag::Assets;   // until the level is generated
+
+    if (opt.headless) {
+        if (!gTarget.initOffscreen(opt.width, opt.height)) return -1;
+    }
+    else {
+        int fbWidth = 0, fbHeight = 0;
+        glfwGetFramebufferSize(window, &fbWidth, &fbHeight);
+        gTarget.initWindow(fbWidth, fbHeight);
+    }
+    gViewport.init(gTarget.getWidth(), gTarget.getHeight(), CameraLens());
 
-    Shader animShader("anim_model.vs", "anim_model.fs");
-    Shader staticShader("static_model.vs", "static_model.fs");
-    gStaticShader = &staticShader;
+    glEnable(GL_DEPTH_TEST);
+    glDepthFunc(GL_LEQUAL);    // lets the sky triangle at z = 1 pass against the cleared depth
+    glEnable(GL_CULL_FACE);
 
-    gBox.initUnitCube("C:/Users/User/Source/Repos/LearnOpenGL/resources/textures/green.jpg");
+    gShaders.init("shader_cache");
+    gShaders.watching = opt.watchShaders;
+    gUseOcclusion = opt.occlusion;
+
+    gAnimShader = gShaders.load("anim_model.vs", "anim_model.fs", [](ShaderProgram& shader) {
+        bindUniformBlocks(shader);
+        shader.setInt("texture_diffuse1", 0);
+        shader.setInt("bonePalette", BONE_PALETTE_UNIT);
+        shader.setInt("shadowMap", SHADOW_MAP_UNIT);
+        shader.setInt("lightData", BONE_PALETTE_UNIT);
+        shader.setInt("clusterLists", CLUSTER_LIST_UNIT);
+    });
+
+    // Coin material never changes, so it is set once instead of per draw
+    gStaticShader = gShaders.load("static_model.vs", "static_model.fs", [](ShaderProgram& shader) {
+        bindUniformBlocks(shader);
+        shader.setBool("useLighting", true);
+        shader.setBool("useTexture", false);
+        shader.setVec3("objectColor", glm::vec3(1.0f, 0.84f, 0.0f));
+        shader.setInt("shadowMap", SHADOW_MAP_UNIT);
+        shader.setInt("lightData", BONE_PALETTE_UNIT);
+        shader.setInt("clusterLists", CLUSTER_LIST_UNIT);
+    });
+
+    int jobThreads = opt.jobThreads > 0 ? opt.jobThreads : std::max(1, (int)std::thread::hardware_concurrency());
+    gJobs.start(jobThreads - 1);
+
+    // A fixed part for the camera, shadow, light and particle data and the player's bones,
+    // plus an ObjectData slot for every piece and coin of every block the window can hold
+    const long long windowBlocks = gWorld.streaming.blocksAhead(Block::SIZE) + gWorld.streaming.blocksBehind(Block::SIZE) + 1;
+    gStream.init(1 << 20, windowBlocks * (MAX_LEVEL_PIECES + Block::MAX_COINS), sizeof(ObjectDataStd140));
+    initBonePalette();
+    initLightClusters();
+
+    gBox.initUnitCube(assetPath("green.jpg"));
     gFloorTile.init();
 
-    const std::string base = "C:/Users/User/source/repos/LearnOpenGL/resources/objects/player/";
-    Model playerModel(base + "Idle.dae");
-    Animation runAnim(base + "Running.dae", &playerModel);
-    Animation jumpAnim(base + "Jump.dae", &playerModel);
-    Animation slideAnim(base + "Running Slide.dae", &playerModel);
+    gLevelShader = gShaders.load("level.vs", "level.fs", [](ShaderProgram& shader) {
+        bindUniformBlocks(shader);
+        shader.setInt("floorTexture", 0);
+        shader.setInt("boxTexture", 1);
+        shader.setInt("shadowMap", SHADOW_MAP_UNIT);
+        shader.setInt("lightData", BONE_PALETTE_UNIT);
+        shader.setInt("clusterLists", CLUSTER_LIST_UNIT);
+    });
+
+    // Depth-only variants of the same vertex shaders for the shadow cascades
+    gShadowLevelShader = gShaders.load("level.vs", "shadow_depth.fs", bindUniformBlocks);
+    gShadowAnimShader = gShaders.load("anim_model.vs", "shadow_depth.fs", [](ShaderProgram& shader) {
+        bindUniformBlocks(shader);
+        shader.setInt("bonePalette", BONE_PALETTE_UNIT);
+    });
+    gShadowStaticShader = gShaders.load("static_model.vs", "shadow_depth.fs", bindUniformBlocks);
+    gShadows.init(1024, glm::vec3(-0.35f, -1.0f, -0.45f));
+
+    if (LevelBatch::supported()) {
+        gLevelBatch.init(kFloorVerts, sizeof(kFloorVerts) / sizeof(kFloorVerts[0]), kFloorIdx, sizeof(kFloorIdx) / sizeof(kFloorIdx[0]),
+            kUnitCubeVerts, sizeof(kUnitCubeVerts) / sizeof(kUnitCubeVerts[0]), kUnitCubeIdx, sizeof(kUnitCubeIdx) / sizeof(kUnitCubeIdx[0]),
+            "level_cull.cs");
+        gUseLevelBatch = true;
+    }
+    std::cout << "[Level] " << (gUseLevelBatch ? "multi-draw indirect" : "per-draw (GL 3.3)")
+        << (gLevelBatch.hasGpuCulling() ? " + GPU culling" : "") << std::endl;
+
+    Model playerModel(assetPath("Idle.dae"));
+    Animation runAnim(assetPath("Running.dae"), &playerModel);
+    Animation jumpAnim(assetPath("Jump.dae"), &playerModel);
+    Animation slideAnim(assetPath("Running Slide.dae"), &playerModel);
     Animator animator(&runAnim);
 
     // Load coin model
-    Model coinModel("C:/Users/User/Source/Repos/LearnOpenGL/resources/objects/coin/Chinese Coin.fbx");
+    Model coinModel(assetPath("Chinese Coin.fbx"));
     std::cout << "[Coin] meshes=" << coinModel.meshes.size() << std::endl;
     gCoinModel = &coinModel;
+    gCoinLod.build(coinModel, assetPath("Chinese Coin.lod"));   // cooked LODs, cached next to the model
+
+    gImpostorShader = gShaders.load("coin_impostor.vs", "coin_impostor.fs", [](ShaderProgram& shader) {
+        bindUniformBlocks(shader);
+        shader.setVec3("objectColor", glm::vec3(1.0f, 0.84f, 0.0f));
+    });
+    initCoinImpostors();
+
+    gGpuTimer.init();
+    QualitySettings best;
+    best.shadowResolution = gShadows.size();
+    best.coinLodBias = gCoinLod.lodBias;
+    best.drawBlocks = gDrawBlocksAhead;
+    gQuality.init(best);
+    // headless and benchmark runs keep full quality so their output stays comparable
+    gQuality.enabled = !opt.headless && opt.benchFrames == 0;
+
+    // Load skybox: the panorama is converted to a cubemap once and cached next to it. Without
+    // the panorama there is no sky pass and the clear colour shows instead.
+    gSkybox.init(assetPath("sky_water_landscape.jpg"), assetPath("sky_water_landscape.cube"), 1024);
+    gSkyboxShader = gShaders.load("skybox.vs", "skybox.fs");
+
+    gParticles.init("particle_update.glsl");
+    gParticleShader = gShaders.load("particle.vs", "particle.fs", bindUniformBlocks);
+
+    ShaderProgram* gameOverShader = gShaders.load("game_over.vs", "game_over.fs");
+    gGameOverScreen.init();
+    gShaders.report();
+
+    // Generate the level start once; restarts copy it
+    currentMemTag() = MemTag::World;
+    gWorldStart.reset(LEVEL_SEED);
+    gWorld.restartFrom(gWorldStart);
+    currentMemTag() = MemTag::General;
+
+    bool showRenderStats = false;
+    Animation* activeAnim = &runAnim;
 
-    // Load skybox
-    std::string envPath = "C:/Users/User/Source/Repos/LearnOpenGL/resources/objects/map/free-skybox-basic-sky/source/basic_skybox_3d.fbx";
-    Model environmentModel(envPath);
-    std::cout << "[Environment] meshes=" << environmentModel.meshes.size() << std::endl;
-    gEnvironmentModel = &environmentModel;
-    gSkyboxTexture = LoadTexture2D("C:/Users/User/Source/Repos/LearnOpenGL/resources/objects/map/free-skybox-basic-sky/textures/sky_water_landscape.jpg", false);
+    // Per-frame work after the simulation step. Animation feeds the slide offset into the
+    // camera; culling and light binning need the camera. Built once, submitted every frame.
+    std::vector<glm::mat4> playerBones;
+    TaskGraph frameJobs;
+    TaskGraph::Task animationTask = frameJobs.add("animation", [&] {
+        MemoryScope memory(MemTag::Animation);
+        Animation* desired = &runAnim;
+        if (gWorld.player.state == AnimState::Jumping) desired = &jumpAnim;
+        else if (gWorld.player.state == AnimState::Sliding) desired = &slideAnim;
 
-    // Generate initial blocks
-    for (int i = 0; i < 50; ++i) {
-        generateNextBlock();
-    }
+        if (desired != activeAnim) {
+            animator.PlayAnimation(desired);
+            activeAnim = desired;
+        }
+        animator.UpdateAnimation(deltaTime);
 
-    bool prevSpace = false, prevS = false, prevR = false;
-    bool prevA = false, prevD = false;
-    Animation* activeAnim = &runAnim;
+        playerBones = animator.GetFinalBoneMatrices();
+        if (gWorld.player.sliding) gWorld.player.updateSlideRootMotion(playerBones);
+        playerBones = gWorld.player.removeRootMotion(playerBones);
+    });
+    TaskGraph::Task cameraTask = frameJobs.add("camera", [&] { MemoryScope memory(MemTag::Render); updateCamera(deltaTime); });
+    TaskGraph::Task occlusionTask = frameJobs.add("occlusion", [&] { MemoryScope memory(MemTag::Render); cullOccluded(gCamera); });
+    TaskGraph::Task blocksTask = frameJobs.add("blocks", [&] { MemoryScope memory(MemTag::Render); cullBlocks(gCamera); });
+    TaskGraph::Task coinsTask = frameJobs.add("coins", [&] { MemoryScope memory(MemTag::Render); cullCoins(gCamera, (float)gSceneTarget->getHeight()); });
+    TaskGraph::Task lightsTask = frameJobs.add("lights", [&] { MemoryScope memory(MemTag::Render); binLights(gCamera); });
+    frameJobs.depends(cameraTask, animationTask);
+    frameJobs.depends(occlusionTask, cameraTask);
+    frameJobs.depends(blocksTask, occlusionTask);
+    frameJobs.depends(coinsTask, occlusionTask);
+    frameJobs.depends(lightsTask, cameraTask);
+    std::vector<double> benchTaskMs(frameJobs.size(), 0.0);
+
+    // Benchmarks drive the simulation with recorded (or fixed 60 Hz) steps and time the
+    // whole frame including GPU completion; the first frames are warmup and not reported.
+    const bool fixedStep = opt.headless || opt.benchFrames > 0;
+    const int benchWarmup = opt.benchFrames > 0 ? 10 : 0;
+    if (!opt.runLogPath.empty() && gRunLog.open(opt.runLogPath)) {
+        gRunLogFlags = (replay.frames.empty() ? 0 : RUN_LOG_REPLAY) | (fixedStep ? RUN_LOG_FIXED_STEP : 0);
+        beginRunLog();
+    }
+    // The harness's own per-frame bookkeeping is reserved up front so that --alloc-budget only
+    // counts the game's allocations: a recording grows by one entry per frame (an hour at 60 Hz
+    // for an open-ended run), the benchmark keeps one sample per timed frame.
+    FrameTimings benchTimings;
+    if (opt.benchFrames > 0) benchTimings.reserve(opt.benchFrames);
+    if (!opt.recordPath.empty()) {
+        size_t expected = !replay.frames.empty() ? replay.frames.size()
+            : opt.benchFrames > 0 ? (size_t)(opt.benchFrames + benchWarmup) : (size_t)60 * 60 * 60;
+        recording.frames.reserve(expected);
+    }
+    // allocations per frame after the warmup frames, checked against --alloc-budget
+    const int memoryWarmup = 10;
+    long long frameAllocsSum = 0, frameAllocsMax = 0;
+    int frameAllocsCount = 0;
+    size_t replayCursor = 0;
+    int frameIndex = 0;
+    lastFrame = (float)glfwGetTime();
 
     while (!glfwWindowShouldClose(window)) {
+        auto frameStart = std::chrono::steady_clock::now();
         float now = (float)glfwGetTime();
-        float rawDeltaTime = now - lastFrame;
+        float wallDelta = now - lastFrame;
         lastFrame = now;
 
-        // Apply speed multiplier to deltaTime
-        deltaTime = rawDeltaTime * gGameSpeed;
-
-        glfwPollEvents();
-
-        bool rDown = (glfwGetKey(window, GLFW_KEY_R) == GLFW_PRESS);
-
-        if (gGameOver) {
-            if (rDown && !prevR) {
-                ResetAll(window, animator, runAnim);
-                activeAnim = &runAnim;
-            }
-            prevR = rDown;
-
-            glClearColor(0.15f, 0.02f, 0.02f, 1.0f);
-            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-            animShader.use();
-            glm::mat4 projection = glm::perspective(glm::radians(50.0f), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 600.0f);
-            glm::mat4 view = computeFixedChaseCamView();
-            animShader.setMat4("projection", projection);
-            animShader.setMat4("view", view);
-
-            drawBlocks(animShader);
-            drawCoins(animShader, projection, view);
-
-            auto transforms = animator.GetFinalBoneMatrices();
-            for (int i = 0; i < (int)transforms.size(); ++i)
-                animShader.setMat4("finalBonesMatrices[" + std::to_string(i) + "]", transforms[i]);
+        // The game-over screen is a still image: once its fade has settled, an interactive run
+        // sleeps until input arrives (with a slow heartbeat) instead of spinning at full rate.
+        bool idle = gWorld.gameOver && gGameOverScreen.hasCapture() && !fixedStep && replay.frames.empty() &&
+            gClock - gGameOverStart > GAME_OVER_FADE;
+        if (idle) glfwWaitEventsTimeout(0.5);
+        else glfwPollEvents();
+        gShaders.poll();
+
+        FrameInput input;
+        if (!replay.frames.empty()) {
+            if (replayCursor >= replay.frames.size()) break;
+            input = replay.frames[replayCursor++];
+            pollFrameInput(0.0f);   // live input is ignored during a replay
+        }
+        else {
+            input = pollFrameInput(fixedStep ? 1.0f / 60.0f : wallDelta);
+        }
+        if (!opt.recordPath.empty()) recording.frames.push_back(input);
 
-            glm::mat4 model = glm::mat4(1.0f);
-            model = glm::translate(model, player.pos);
-            model = glm::rotate(model, glm::radians(player.yaw), glm::vec3(0, 1, 0));
-            model = glm::scale(model, glm::vec3(player.scale));
-            animShader.setMat4("model", model);
-            playerModel.Draw(animShader);
+        uint32_t pressed = input.pressed;
 
-            // Draw skybox last
-            drawEnvironment(projection, view);
+        float rawDeltaTime = input.dt;
 
-            glfwSwapBuffers(window);
-            continue;
+        // a restart begins from a standing start, however long the game-over screen was idle
+        if (gWorld.gameOver && (pressed & INPUT_RESTART)) {
+            ResetAll(window, animator, runAnim);
+            activeAnim = &runAnim;
+            rawDeltaTime = 0.0f;
         }
+        gClock += rawDeltaTime;
 
-        if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
-            glfwSetWindowShouldClose(window, true);
-
-        bool spaceDown = (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS);
-        if (spaceDown && !prevSpace) player.jump();
-        prevSpace = spaceDown;
-
-        bool sDown = (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS);
-        if (sDown && !prevS) player.startSlide();
-        prevS = sDown;
+        // Apply speed multiplier to deltaTime
+        deltaTime = rawDeltaTime * gWorld.speed;
 
-        bool aDown = (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS);
-        if (aDown && !prevA) player.turnLeft();
-        prevA = aDown;
+        if (gWorld.gameOver) {
+            float fade = std::min(1.0f, (gClock - gGameOverStart) / GAME_OVER_FADE);
+            gGameOverScreen.present(gameOverShader->ID, gTarget, fade);
+        }
+        else {
+            gGpuTimer.begin();
+            beginScene();
+
+            if (input.buttons & INPUT_QUIT)
+                glfwSetWindowShouldClose(window, true);
+
+            // F2: toggle the depth pre-pass, F3: show render queue stats in the title,
+            // F4: toggle the quality governor. Queued like the gameplay keys, so a tap shorter
+            // than a frame still counts and recordings replay the toggles.
+            if (pressed & INPUT_TOGGLE_PREPASS) {
+                gRenderQueue.depthPrepass = !gRenderQueue.depthPrepass;
+                std::cout << "[RenderQueue] depth pre-pass " << (gRenderQueue.depthPrepass ? "on" : "off") << std::endl;
+            }
+            if (pressed & INPUT_TOGGLE_STATS) showRenderStats = !showRenderStats;
+            if (pressed & INPUT_TOGGLE_QUALITY) {
+                gQuality.enabled = !gQuality.enabled;
+                if (!gQuality.enabled) {
+                    gQuality.reset();
+                    applyQuality(gQuality.settings());
+                }
+                std::cout << "[Quality] governor " << (gQuality.enabled ? "on" : "off") << std::endl;
+            }
 
-        bool dDown = (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS);
-        if (dDown && !prevD) player.turnRight();
-        prevD = dDown;
+            stepWorld(input, rawDeltaTime, pressed);
+            logWorldEvents();
+            emitWorldEvents();
+            trackDrawRange();
+
+            // Update window title with speed
+            static float titleUpdateTimer = 0.0f;
+            titleUpdateTimer += rawDeltaTime;
+            if (titleUpdateTimer > 0.5f) {
+                titleUpdateTimer = 0.0f;
+                char titleBuffer[512];
+                int len = snprintf(titleBuffer, sizeof(titleBuffer),
+                    "Temple Run - HP: %d | Coins: %d | Speed: %.2fx",
+                    gWorld.hp, gWorld.coinCount, gWorld.speed);
+                if (showRenderStats && len > 0 && len < (int)sizeof(titleBuffer)) {
+                    const RenderStats& rs = gRenderQueue.stats;
+                    snprintf(titleBuffer + len, sizeof(titleBuffer) - len,
+                        " | draws %d (pre %d) prog %d tex %d vao %d obj %d | blocks %d (%zu KB) | occluded %d + %d coins"
+                        " | heap %.1f MB (peak %.1f) %lld allocs/frame | GPU %.1f MB",
+                        rs.drawCalls, rs.prepassDraws, rs.programBinds, rs.textureBinds, rs.vaoBinds, rs.objectBinds,
+                        gWorld.streaming.blocks(), gWorld.streaming.bytes() / 1024, gPiecesOccluded, gCoinsOccluded,
+                        gHeap.bytes() / 1048576.0, gHeap.peak() / 1048576.0, gHeap.lastFrameAllocations(),
+                        gGpuMemory.total() / 1048576.0);
+                }
+                glfwSetWindowTitle(window, titleBuffer);
+            }
 
-        float thisFrameMouseDeltaX = g_mouseDeltaX;
-        g_mouseDeltaX = 0.0f;
-        player.updatePhysics(deltaTime, thisFrameMouseDeltaX);
+            frameJobs.submit(gJobs);
 
-        // Update block generation
-        updateBlockGeneration();
+            glClearColor(0.06f, 0.06f, 0.08f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        // Check collisions
-        checkBlockCollisions();
-        checkCoinCollisions();
+            renderFrame(frameJobs, playerModel, playerBones, rawDeltaTime);
+            if (opt.benchFrames > 0 && frameIndex >= benchWarmup)
+                for (int t = 0; t < frameJobs.size(); ++t) benchTaskMs[t] += frameJobs.milliseconds(t);
+
+            endScene();
+            gGpuTimer.end();
+
+            // the run just ended: keep its last frame for the game-over screen
+            if (gWorld.gameOver) {
+                gRunLog.endRun(gWorld.time, gWorld.coinCount, gWorld.playerBlock, false);
+                char title[128] = "GAME OVER - Press R to Restart";
+                if (gRunLog.isOpen())
+                    snprintf(title, sizeof(title), "GAME OVER - Coins: %d (best %d) - Press R to Restart",
+                        gWorld.coinCount, gRunLog.bestCoins());
+                glfwSetWindowTitle(window, title);
+                gGameOverScreen.capture(gTarget);
+                gGameOverStart = gClock;
+            }
 
-        // Increase game speed
-        gGameTime += rawDeltaTime;
-        gGameSpeed = 1.0f + (gGameTime * gSpeedIncreaseRate);
-        if (gGameSpeed > gMaxSpeed) {
-            gGameSpeed = gMaxSpeed;
+            // CPU time is taken before the swap so vsync waits do not count as load
+            float cpuMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - frameStart).count();
+            gRunLog.append(RunLogType::FrameTime, gWorld.time, cpuMs, gGpuTimer.milliseconds(), wallDelta * 1000.0f);
+            if (gQuality.update(cpuMs, gGpuTimer.milliseconds(), wallDelta)) {
+                gRunLog.append(RunLogType::Quality, gWorld.time, (float)gQuality.gpuTier(), (float)gQuality.cpuTier(),
+                    (float)gQuality.settings().shadowResolution);
+                applyQuality(gQuality.settings());
+            }
         }
 
-        // Update window title with speed
-        static float titleUpdateTimer = 0.0f;
-        titleUpdateTimer += rawDeltaTime;
-        if (titleUpdateTimer > 0.5f) {
-            titleUpdateTimer = 0.0f;
-            char titleBuffer[256];
-            snprintf(titleBuffer, sizeof(titleBuffer),
-                "Temple Run - HP: %d | Coins: %d | Speed: %.2fx",
-                gHP, gCoinCount, gGameSpeed);
-            glfwSetWindowTitle(window, titleBuffer);
+        if (opt.captureEvery > 0 && frameIndex % opt.captureEvery == 0) {
+            char name[64];
+            snprintf(name, sizeof(name), "/frame_%05d.png", frameIndex);
+            gTarget.savePNG(opt.captureDir + name);
         }
-
-        Animation* desired = &runAnim;
-        if (player.state == AnimState::Jumping) desired = &jumpAnim;
-        else if (player.state == AnimState::Sliding) desired = &slideAnim;
-
-        if (desired != activeAnim) {
-            animator.PlayAnimation(desired);
-            activeAnim = desired;
+        if (!gTarget.isOffscreen()) {
+            // Events are stamped when GLFW delivers them; polling again before the vsync wait
+            // stamps the ones that arrived during this frame's work near when they happened.
+            if (!idle) glfwPollEvents();
+            glfwSwapBuffers(window);
         }
-        animator.UpdateAnimation(deltaTime);
 
-        if (player.sliding) {
-            auto transforms = animator.GetFinalBoneMatrices();
-            player.updateSlideRootMotion(transforms);
+        long long frameAllocs = gHeap.endFrame();
+        if (frameIndex >= memoryWarmup) {
+            frameAllocsSum += frameAllocs;
+            frameAllocsMax = std::max(frameAllocsMax, frameAllocs);
+            frameAllocsCount++;
         }
 
-        glClearColor(0.06f, 0.06f, 0.08f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-        animShader.use();
-        glm::mat4 projection = glm::perspective(glm::radians(50.0f), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 600.0f);
-        glm::mat4 view = computeFixedChaseCamView();
-        animShader.setMat4("projection", projection);
-        animShader.setMat4("view", view);
-
-        drawBlocks(animShader);
-        drawCoins(animShader, projection, view);
-
-        auto transforms = animator.GetFinalBoneMatrices();
-        transforms = player.removeRootMotion(transforms);
-
-        for (int i = 0; i < (int)transforms.size(); ++i)
-            animShader.setMat4("finalBonesMatrices[" + std::to_string(i) + "]", transforms[i]);
-
-        glm::mat4 model = glm::mat4(1.0f);
-        model = glm::translate(model, player.pos);
-        model = glm::rotate(model, glm::radians(player.yaw), glm::vec3(0, 1, 0));
-        model = glm::scale(model, glm::vec3(player.scale));
-        animShader.setMat4("model", model);
-        playerModel.Draw(animShader);
-
-        // Draw skybox last
-        drawEnvironment(projection, view);
+        if (opt.benchFrames > 0) {
+            glFinish();
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frameStart).count();
+            if (frameIndex >= benchWarmup) benchTimings.add(ms);
+            if (frameIndex + 1 >= opt.benchFrames + benchWarmup) {
+                frameIndex++;
+                break;
+            }
+        }
+        frameIndex++;
+    }
 
-        glfwSwapBuffers(window);
-        prevR = rDown;
+    if (opt.benchFrames > 0) {
+        std::string label = (opt.replayPath.empty() ? std::string("fixed 60 Hz run") : opt.replayPath)
+            + ", " + std::to_string(gJobs.size()) + " job threads";
+        benchTimings.report(label.c_str());
+        if (benchTimings.count() > 0) {
+            std::cout << "[Jobs] mean task ms:";
+            for (int t = 0; t < frameJobs.size(); ++t)
+                std::cout << " " << frameJobs.name(t) << " " << benchTaskMs[t] / benchTimings.count();
+            std::cout << std::endl;
+        }
+        if ((int)benchTimings.count() < opt.benchFrames)
+            std::cout << "[Bench] replay ended after " << frameIndex << " frames" << std::endl;
+        if (frameAllocsCount > 0)
+            std::printf("[Memory] allocations per frame: mean %.1f, max %lld\n", (double)frameAllocsSum / frameAllocsCount, frameAllocsMax);
+        gHeap.report();
+        gGpuMemory.report();
     }
 
+    // hard budgets, so automated runs fail on a regression
+    int exitCode = 0;
+    if (opt.allocBudget >= 0 && frameAllocsMax > opt.allocBudget) {
+        std::printf("[Memory] over budget: %lld allocations in one frame (budget %lld)\n", frameAllocsMax, opt.allocBudget);
+        exitCode = 1;
+    }
+    if (opt.heapBudgetMB > 0 && gHeap.peak() > opt.heapBudgetMB * 1048576ll) {
+        std::printf("[Memory] over budget: heap peaked at %.2f MB (budget %d MB)\n", gHeap.peak() / 1048576.0, opt.heapBudgetMB);
+        exitCode = 1;
+    }
+    if (!opt.recordPath.empty()) recording.save(opt.recordPath);
+    if (gRunLog.running()) gRunLog.endRun(gWorld.time, gWorld.coinCount, gWorld.playerBlock, true);
+    gRunLog.close();
+    if (gInput.dropped() > 0) std::cout << "[Input] " << gInput.dropped() << " events dropped (queue full)" << std::endl;
+    if (gStream.overflows() > 0)
+        std::cout << "[StreamBuffer] " << gStream.overflows() << " frames ran out of room and dropped data" << std::endl;
+    gWorld.streaming.report();
+
+    gJobs.stop();
+    gStream.destroy();
     glfwTerminate();
-    return 0;
+    return exitCode;
 }
 
 void framebuffer_size_callback(GLFWwindow* /*window*/, int width, int height) {
-    glViewport(0, 0, width, height);
+    // offscreen targets keep the size given on the command line
+    if (gTarget.isOffscreen()) return;
+    gTarget.resize(width, height);
+    gViewport.resize(width, height);
 }
 
 void mouse_callback(GLFWwindow* /*window*/, double xpos, double ypos) {
@@ -1246,7 +1637,29 @@ void mouse_callback(GLFWwindow* /*window*/, double xpos, double ypos) {
         g_mouseLastX = (float)xpos;
         g_mouseFirstMove = false;
     }
-    float dx = (float)xpos - g_mouseLastX;
+    InputEvent e;
+    e.time = glfwGetTime();
+    e.mouseDx = (float)xpos - g_mouseLastX;
     g_mouseLastX = (float)xpos;
-    g_mouseDeltaX += dx;
-}
\ No newline at end of file
+    gInput.push(e);
+}
+
+void key_callback(GLFWwindow* /*window*/, int key, int /*scancode*/, int action, int /*mods*/) {
+    if (action == GLFW_REPEAT) return;
+    InputEvent e;
+    switch (key) {
+    case GLFW_KEY_SPACE: e.button = INPUT_JUMP; break;
+    case GLFW_KEY_S: e.button = INPUT_SLIDE; break;
+    case GLFW_KEY_A: e.button = INPUT_LEFT; break;
+    case GLFW_KEY_D: e.button = INPUT_RIGHT; break;
+    case GLFW_KEY_R: e.button = INPUT_RESTART; break;
+    case GLFW_KEY_ESCAPE: e.button = INPUT_QUIT; break;
+    case GLFW_KEY_F2: e.button = INPUT_TOGGLE_PREPASS; break;
+    case GLFW_KEY_F3: e.button = INPUT_TOGGLE_STATS; break;
+    case GLFW_KEY_F4: e.button = INPUT_TOGGLE_QUALITY; break;
+    default: return;
+    }
+    e.time = glfwGetTime();
+    e.down = action == GLFW_PRESS;
+    gInput.push(e);
+}
\ No newline at end of file
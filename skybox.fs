@@ -0,0 +1,11 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec3 Direction;
+
+uniform samplerCube skyCubemap;
+
+void main()
+{
+    FragColor = texture(skyCubemap, normalize(Direction));
+}
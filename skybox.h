@@ -0,0 +1,150 @@
+#ifndef SKYBOX_H
+#define SKYBOX_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <stb_image.h>
+
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Converts an equirectangular panorama into the six faces of a cubemap (RGB8, GL face order).
+// Bilinear lookups, row 0 of the panorama is straight up.
+inline void EquirectToCubeFaces(const unsigned char* src, int srcW, int srcH, int channels,
+                                int faceSize, std::vector<unsigned char>& faces) {
+    const float PI = 3.14159265358979f;
+    faces.resize((size_t)faceSize * faceSize * 3 * 6);
+
+    auto sample = [&](float u, float v, unsigned char* out) {
+        float x = u * srcW - 0.5f, y = v * srcH - 0.5f;
+        int x0 = (int)std::floor(x), y0 = (int)std::floor(y);
+        float fx = x - x0, fy = y - y0;
+        for (int c = 0; c < 3; ++c) {
+            float acc = 0.0f;
+            for (int dy = 0; dy < 2; ++dy) {
+                int yy = y0 + dy;
+                yy = yy < 0 ? 0 : (yy >= srcH ? srcH - 1 : yy);
+                for (int dx = 0; dx < 2; ++dx) {
+                    int xx = (x0 + dx + srcW) % srcW;   // wraps horizontally
+                    float w = (dx ? fx : 1.0f - fx) * (dy ? fy : 1.0f - fy);
+                    acc += w * src[((size_t)yy * srcW + xx) * channels + (channels >= 3 ? c : 0)];
+                }
+            }
+            out[c] = (unsigned char)(acc + 0.5f);
+        }
+    };
+
+    for (int face = 0; face < 6; ++face) {
+        unsigned char* dst = faces.data() + (size_t)face * faceSize * faceSize * 3;
+        for (int y = 0; y < faceSize; ++y) {
+            float tc = 2.0f * (y + 0.5f) / faceSize - 1.0f;
+            for (int x = 0; x < faceSize; ++x) {
+                float sc = 2.0f * (x + 0.5f) / faceSize - 1.0f;
+                glm::vec3 d;
+                switch (face) {
+                case 0: d = glm::vec3(1.0f, -tc, -sc); break;    // +X
+                case 1: d = glm::vec3(-1.0f, -tc, sc); break;    // -X
+                case 2: d = glm::vec3(sc, 1.0f, tc); break;      // +Y
+                case 3: d = glm::vec3(sc, -1.0f, -tc); break;    // -Y
+                case 4: d = glm::vec3(sc, -tc, 1.0f); break;     // +Z
+                default: d = glm::vec3(-sc, -tc, -1.0f); break;  // -Z
+                }
+                d = glm::normalize(d);
+                float u = std::atan2(d.z, d.x) / (2.0f * PI) + 0.5f;
+                float v = 0.5f - std::asin(d.y) / PI;
+                sample(u, v, dst + ((size_t)y * faceSize + x) * 3);
+            }
+        }
+    }
+}
+
+// Cubemap sky drawn as one fullscreen triangle at the far plane. Drawn after the opaque
+// geometry so early depth testing rejects every covered pixel; cost is independent of
+// any source mesh and needs no per-frame state toggles (depth func is GL_LEQUAL globally).
+class Skybox {
+public:
+    void init(const std::string& equirectPath, const std::string& cachePath, int faceSize) {
+        std::vector<unsigned char> faces;
+        if (!loadCache(cachePath, faceSize, faces)) {
+            stbi_set_flip_vertically_on_load(false);
+            int w, h, n;
+            unsigned char* data = stbi_load(equirectPath.c_str(), &w, &h, &n, 0);
+            if (!data) {
+                // ready() stays false and the frame keeps its clear colour behind the level
+                std::cerr << "[Sky] cannot load " << equirectPath << ", using the clear colour\n";
+                return;
+            }
+            EquirectToCubeFaces(data, w, h, n, faceSize, faces);
+            stbi_image_free(data);
+            saveCache(cachePath, faceSize, faces);
+        }
+
+        glGenTextures(1, &cubemap);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, cubemap);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        size_t faceBytes = (size_t)faceSize * faceSize * 3;
+        for (int i = 0; i < 6; ++i)
+            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB8, faceSize, faceSize, 0, GL_RGB, GL_UNSIGNED_BYTE, faces.data() + faceBytes * i);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+        glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+
+        // the triangle is generated from gl_VertexID, but core profile still needs a VAO bound
+        glGenVertexArrays(1, &VAO);
+    }
+
+    bool ready() const { return cubemap != 0; }
+
+    // invViewProj must be built from the rotation-only view so the sky stays at infinity.
+    void draw(unsigned int program, const glm::mat4& invViewProj) const {
+        if (!cubemap) return;
+        glUseProgram(program);
+        glUniformMatrix4fv(glGetUniformLocation(program, "invViewProj"), 1, GL_FALSE, &invViewProj[0][0]);
+        glUniform1i(glGetUniformLocation(program, "skyCubemap"), 0);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, cubemap);
+        glBindVertexArray(VAO);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        glBindVertexArray(0);
+    }
+
+private:
+    static const uint32_t CACHE_MAGIC = 0x45425543u;   // "CUBE"
+
+    static bool loadCache(const std::string& path, int faceSize, std::vector<unsigned char>& faces) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) return false;
+        uint32_t magic = 0, size = 0;
+        in.read((char*)&magic, sizeof(magic));
+        in.read((char*)&size, sizeof(size));
+        if (!in || magic != CACHE_MAGIC || (int)size != faceSize) return false;
+        faces.resize((size_t)faceSize * faceSize * 3 * 6);
+        in.read((char*)faces.data(), faces.size());
+        return (bool)in;
+    }
+
+    static void saveCache(const std::string& path, int faceSize, const std::vector<unsigned char>& faces) {
+        std::ofstream out(path, std::ios::binary);
+        if (!out) return;
+        uint32_t magic = CACHE_MAGIC, size = (uint32_t)faceSize;
+        out.write((const char*)&magic, sizeof(magic));
+        out.write((const char*)&size, sizeof(size));
+        out.write((const char*)faces.data(), faces.size());
+    }
+
+    GLuint cubemap = 0;
+    GLuint VAO = 0;
+};
+
+#endif
@@ -0,0 +1,14 @@
+#version 330 core
+
+uniform mat4 invViewProj;
+
+out vec3 Direction;
+
+void main()
+{
+    // fullscreen triangle, z = w so it lands exactly on the far plane
+    vec2 p = vec2((gl_VertexID == 1) ? 3.0 : -1.0, (gl_VertexID == 2) ? 3.0 : -1.0);
+    vec4 world = invViewProj * vec4(p, 1.0, 1.0);
+    Direction = world.xyz / world.w;
+    gl_Position = vec4(p, 1.0, 1.0);
+}
@@ -1,4 +1,6 @@
 #version 330 core
+#include "lighting.glsl"
+
 out vec4 FragColor;
 
 in vec2 TexCoords;
@@ -7,9 +9,6 @@ in vec3 Normal;
 
 uniform sampler2D texture_diffuse1;
 uniform vec3 objectColor;
-uniform vec3 lightColor;
-uniform vec3 lightPos;
-uniform vec3 viewPos;
 uniform bool useLighting;
 uniform bool useTexture;
 
@@ -24,21 +23,22 @@ void main()
     }
     
     if (useLighting) {
-        float ambientStrength = 0.3;
-        vec3 ambient = ambientStrength * lightColor;
+        vec3 lightColor = sunColor.rgb;
+        vec3 ambient = sunColor.w * lightColor;
         
         vec3 norm = normalize(Normal);
-        vec3 lightDir = normalize(lightPos - FragPos);
+        vec3 lightDir = -sunDirection.xyz;
         float diff = max(dot(norm, lightDir), 0.0);
-        vec3 diffuse = diff * lightColor;
+        float shadow = diff > 0.0 ? sunShadow(FragPos, norm) : 1.0;
+        vec3 diffuse = diff * shadow * lightColor;
         
         float specularStrength = 0.8;
-        vec3 viewDir = normalize(viewPos - FragPos);
+        vec3 viewDir = normalize(viewPos.xyz - FragPos);
         vec3 reflectDir = reflect(-lightDir, norm);
         float spec = pow(max(dot(viewDir, reflectDir), 0.0), 32);
-        vec3 specular = specularStrength * spec * lightColor;
+        vec3 specular = specularStrength * spec * shadow * lightColor;
         
-        vec3 result = (ambient + diffuse + specular) * color;
+        vec3 result = (ambient + diffuse + specular + pointLights(FragPos, norm)) * color;
         FragColor = vec4(result, 1.0);
     } else {
         FragColor = vec4(color, 1.0);
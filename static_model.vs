@@ -4,9 +4,16 @@ layout(location = 0) in vec3 pos;
 layout(location = 1) in vec3 norm;
 layout(location = 2) in vec2 tex;
 
-uniform mat4 projection;
-uniform mat4 view;
-uniform mat4 model;
+layout(std140) uniform FrameData {
+    mat4 projection;
+    mat4 view;
+    vec4 viewPos;
+    vec4 lightPos;
+};
+
+layout(std140) uniform ObjectData {
+    mat4 model;
+};
 
 out vec2 TexCoords;
 out vec3 FragPos;
@@ -0,0 +1,168 @@
+#ifndef STREAM_BUFFER_H
+#define STREAM_BUFFER_H
+
+#include <glad/glad.h>
+
+#include <iostream>
+#include <vector>
+#include <cstring>
+
+// Triple-buffered ring for per-frame GPU data (camera, model matrices, bone palettes).
+// The buffer is bound as uniform ranges and also viewed as a buffer texture for bones.
+// Everything for a frame is written once, then referenced by offset with glBindBufferRange.
+// Each third of the buffer is guarded by a fence so the CPU never overwrites data the
+// GPU is still reading. Uses a persistent coherent mapping when glBufferStorage is
+// available (GL 4.4 / ARB_buffer_storage), otherwise stages on the CPU and uploads the
+// frame region with a single unsynchronized glMapBufferRange before drawing.
+class StreamBuffer {
+public:
+    static const int FRAMES = 3;
+
+    struct Alloc {
+        void* ptr = nullptr;
+        GLintptr offset = 0;
+        GLsizeiptr size = 0;
+        bool valid() const { return ptr != nullptr; }
+    };
+
+    // Each frame region holds bytesPerFrame plus 'slots' separate writes of slotBytes, each
+    // padded to the uniform offset alignment (ObjectData ranges bound one draw at a time).
+    void init(GLsizeiptr bytesPerFrame, long long slots = 0, GLsizeiptr slotBytes = 0) {
+        GLint uboAlign = 256;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uboAlign);
+        alignment = uboAlign > 0 ? uboAlign : 256;
+
+        regionSize = alignUp(bytesPerFrame) + (GLsizeiptr)slots * alignUp(slotBytes);
+        GLsizeiptr totalSize = regionSize * FRAMES;
+
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+
+        persistent = GLAD_GL_VERSION_4_4 || GLAD_GL_ARB_buffer_storage;
+        if (persistent) {
+            GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            glBufferStorage(GL_UNIFORM_BUFFER, totalSize, nullptr, flags);
+            mapped = (unsigned char*)glMapBufferRange(GL_UNIFORM_BUFFER, 0, totalSize, flags);
+            if (!mapped) {
+                std::cerr << "[StreamBuffer] persistent map failed, using staged uploads\n";
+                persistent = false;
+                glDeleteBuffers(1, &buffer);
+                glGenBuffers(1, &buffer);
+                glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+            }
+        }
+        if (!persistent) {
+            glBufferData(GL_UNIFORM_BUFFER, totalSize, nullptr, GL_STREAM_DRAW);
+            staging.resize((size_t)regionSize);
+        }
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+        std::cout << "[StreamBuffer] " << (totalSize / 1024) << " KB (" << slots << " object slots per frame), "
+            << (persistent ? "persistent mapping" : "unsynchronized staging") << std::endl;
+    }
+
+    void destroy() {
+        for (int i = 0; i < FRAMES; ++i) {
+            if (fences[i]) glDeleteSync(fences[i]);
+            fences[i] = 0;
+        }
+        if (buffer) {
+            if (persistent) {
+                glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+                glUnmapBuffer(GL_UNIFORM_BUFFER);
+                glBindBuffer(GL_UNIFORM_BUFFER, 0);
+            }
+            glDeleteBuffers(1, &buffer);
+        }
+        buffer = 0;
+        mapped = nullptr;
+    }
+
+    // Waits until the GPU has finished with the region we are about to reuse.
+    void beginFrame() {
+        GLsync& fence = fences[frame];
+        if (fence) {
+            GLenum r = glClientWaitSync(fence, 0, 0);
+            if (r == GL_TIMEOUT_EXPIRED) {
+                stallCount++;
+                while (r == GL_TIMEOUT_EXPIRED)
+                    r = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+            }
+            glDeleteSync(fence);
+            fence = 0;
+        }
+        cursor = 0;
+        overflowed = false;
+    }
+
+    // Reserves aligned space in the current frame region. Returns an invalid Alloc when full.
+    Alloc allocate(GLsizeiptr size) {
+        Alloc a;
+        GLsizeiptr aligned = alignUp(size);
+        if (cursor + aligned > regionSize) {
+            if (!overflowed) overflowFrames++;   // counted, not printed: this runs inside the frame
+            overflowed = true;
+            return a;
+        }
+        a.offset = regionBase() + cursor;
+        a.size = size;
+        a.ptr = persistent ? (void*)(mapped + a.offset) : (void*)(staging.data() + cursor);
+        cursor += aligned;
+        return a;
+    }
+
+    Alloc write(const void* data, GLsizeiptr size) {
+        Alloc a = allocate(size);
+        if (a.valid()) std::memcpy(a.ptr, data, (size_t)size);
+        return a;
+    }
+
+    // Makes this frame's writes visible to the GPU. Call once, after all writes and before the first draw.
+    void flush() {
+        if (persistent || cursor == 0) return;
+        glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+        void* dst = glMapBufferRange(GL_UNIFORM_BUFFER, regionBase(), cursor,
+            GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+        if (dst) {
+            std::memcpy(dst, staging.data(), (size_t)cursor);
+            glUnmapBuffer(GL_UNIFORM_BUFFER);
+        }
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+
+    void bindRange(GLuint bindingPoint, const Alloc& a) const {
+        glBindBufferRange(GL_UNIFORM_BUFFER, bindingPoint, buffer, a.offset, a.size);
+    }
+
+    // Fences the region written this frame and moves on to the next one.
+    void endFrame() {
+        fences[frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        frame = (frame + 1) % FRAMES;
+    }
+
+    GLuint id() const { return buffer; }
+    GLsizeiptr totalSize() const { return regionSize * FRAMES; }
+    GLsizeiptr bytesUsed() const { return cursor; }
+    bool isPersistent() const { return persistent; }
+    unsigned int stalls() const { return stallCount; }
+    unsigned int overflows() const { return overflowFrames; }   // frames that dropped data
+
+private:
+    GLsizeiptr alignUp(GLsizeiptr n) const { return (n + alignment - 1) / alignment * alignment; }
+    GLintptr regionBase() const { return (GLintptr)frame * regionSize; }
+
+    GLuint buffer = 0;
+    unsigned char* mapped = nullptr;
+    std::vector<unsigned char> staging;
+    GLsync fences[FRAMES] = { 0, 0, 0 };
+    GLsizeiptr regionSize = 0;
+    GLsizeiptr cursor = 0;
+    GLsizeiptr alignment = 256;
+    int frame = 0;
+    bool persistent = false;
+    bool overflowed = false;
+    unsigned int stallCount = 0;
+    unsigned int overflowFrames = 0;
+};
+
+#endif
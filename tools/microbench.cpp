@@ -0,0 +1,343 @@
+// Microbenchmarks for the simulation and render-prep hot paths, headless and without GL.
+// Every case that walks the level runs at several window sizes (blocks) and coin densities
+// (coins per block, replacing the generated patterns; only the cases that read coins see it).
+// Results go to stdout and, for tracking regressions across builds, to a JSON file.
+//
+//   g++ -O2 -std=c++17 -I.. -I<glm include dir> microbench.cpp -o microbench
+//   ./microbench [out.json] [name filter]
+//
+// Animator updates are not covered: an Animation can only be built from an Assimp-loaded
+// Model, which uploads its meshes to GL on load. Root-motion removal, the part of the
+// animation job that is game code, is.
+#include "../game_world.h"
+#include "../draw_list.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <vector>
+
+// Reaches into World for the steps step() normally runs in sequence.
+struct WorldBench {
+    // A window of about 'blocks' blocks, never limited by the memory budget.
+    static void build(World& w, int blocks, uint32_t seed) {
+        StreamingConfig config;
+        config.aheadDistance = blocks * Block::SIZE;
+        config.behindDistance = 2.0f * Block::SIZE;
+        config.minBlocksAhead = blocks;
+        config.memoryBudget = (size_t)1 << 30;
+        w.streaming.config = config;
+        w.reset(seed);
+    }
+
+    // Generates 'count' blocks into an emptied window.
+    static void generate(World& w, int count) {
+        w.blocks.clear();
+        w.streaming.clear();
+        for (int i = 0; i < count; ++i) w.generateNextBlock();
+    }
+
+    static void updateGeneration(World& w) { w.updateBlockGeneration(); }
+    static void blockCollisions(World& w) { w.checkBlockCollisions(); }
+    static void coinCollisions(World& w) { w.checkCoinCollisions(); }
+};
+
+// Replaces every block's coins with 'perBlock' coins on the right lane, where the player
+// standing at the start never picks them up.
+static void setCoinDensity(World& w, int perBlock) {
+    for (Block& block : w.blocks) {
+        block.coins.clear();
+        glm::vec3 forward = getDirectionFromYaw(block.yaw);
+        glm::vec3 right = getRightFromYaw(block.yaw);
+        for (int i = 0; i < perBlock; ++i) {
+            Block::Coin coin;
+            coin.pos = block.centerPos + right + forward * ((i - 2) * 0.8f);
+            coin.pos.y = 1.0f;
+            block.coins.push_back(coin);
+        }
+    }
+}
+
+// Stands in for the stream buffer: ObjectData ranges are numbered, never written.
+struct FakeObjectRange {
+    long long offset, size;
+    bool valid() const { return true; }
+};
+
+// The game's per-draw level path and coins (draw_list.h) with fake GL names: culling against
+// the chase camera, coin LODs, then one item per visible floor, wall, obstacle and coin,
+// sorted. Nothing is occluded.
+struct DrawListBench {
+    CameraRig rig;
+    ScreenSizeLod coinLod;
+    MeshDraw levelMeshes[2];
+    MeshDraw coinMeshes[ScreenSizeLod::MAX_LODS];
+    std::vector<uint8_t> unoccluded;   // empty: every piece counts as unoccluded
+    std::vector<LevelPiece> pieces;
+    std::vector<CoinDraw> coins;
+    std::vector<glm::vec4> impostors;
+    long long objects = 0;
+
+    DrawListBench() {
+        levelMeshes[LEVEL_MESH_FLOOR] = { 1, 1, 6 };
+        levelMeshes[LEVEL_MESH_BOX] = { 2, 2, 36 };
+        for (int i = 0; i < ScreenSizeLod::MAX_LODS; ++i) coinMeshes[i] = { 0, 4u + i, 960 >> (2 * i) };
+        coinLod.center = glm::vec3(0.0f, 0.5f, 0.0f);
+        coinLod.radius = 0.6f;
+        coinLod.available = (1u << ScreenSizeLod::MAX_LODS) - 1;
+    }
+
+    int build(const World& w, RenderQueue& queue) {
+        const int BLOCKS_AHEAD = 1 << 20;   // the whole window
+        const float VIEWPORT_HEIGHT = 720.0f;
+        const unsigned int LEVEL_PROGRAM = 3, COIN_PROGRAM = 5;
+
+        rig.update(w.player.pos, w.player.yaw, false, 1000.0f);   // settled behind the player
+        CameraLens lens;
+        CameraSnapshot cam = rig.snapshot(lens, glm::perspective(lens.fovY, lens.aspect, lens.zNear, lens.zFar));
+        cullLevelPieces(w, BLOCKS_AHEAD, cam, levelMeshes, unoccluded, pieces);
+        cullCoinDraws(w, BLOCKS_AHEAD, cam, VIEWPORT_HEIGHT, coinLod, nullptr, coins, impostors);
+
+        queue.clear();
+        objects = 0;
+        auto object = [this](const glm::mat4&) {
+            FakeObjectRange range = { objects++ * 80, 80 };
+            return range;
+        };
+        auto caster = [](const MeshDraw&, const FakeObjectRange&) {};
+        queueLevelPieces(queue, cam.position, LEVEL_PROGRAM, pieces, object, caster);
+        queueCoinDraws(queue, cam.position, COIN_PROGRAM, coinMeshes, coins, object, caster);
+        queue.sort();
+        return (int)queue.size();
+    }
+};
+
+struct Result {
+    std::string name;
+    int blocks = 0;          // 0 when the case does not depend on the level
+    int coinsPerBlock = -1;  // -1 when the case does not read coins
+    double items = 1.0;      // work items per operation (blocks, tests, draw items); 0: no per-item time
+    long long iterations = 0;
+    double nsMedian = 0.0, nsMin = 0.0;   // per operation
+};
+
+static volatile uint64_t gSink = 0;   // keeps results alive past the optimizer
+
+// Runs op until a batch takes at least 20 ms, then times five batches of that size.
+template <typename Op>
+static void measure(Result& r, Op op) {
+    typedef std::chrono::steady_clock Clock;
+    long long n = 1;
+    for (;;) {
+        auto start = Clock::now();
+        for (long long i = 0; i < n; ++i) op();
+        double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        if (ms >= 20.0 || n >= (1ll << 30)) break;
+        n *= ms < 2.0 ? 8 : 2;
+    }
+    std::vector<double> samples;
+    for (int s = 0; s < 5; ++s) {
+        auto start = Clock::now();
+        for (long long i = 0; i < n; ++i) op();
+        samples.push_back(std::chrono::duration<double, std::nano>(Clock::now() - start).count() / (double)n);
+    }
+    std::sort(samples.begin(), samples.end());
+    r.iterations = n;
+    r.nsMedian = samples[samples.size() / 2];
+    r.nsMin = samples.front();
+}
+
+static void report(const Result& r) {
+    char params[64] = "";
+    if (r.blocks > 0 && r.coinsPerBlock >= 0) std::snprintf(params, sizeof(params), "blocks=%d coins=%d", r.blocks, r.coinsPerBlock);
+    else if (r.blocks > 0) std::snprintf(params, sizeof(params), "blocks=%d", r.blocks);
+    char perItem[32] = "         -";
+    if (r.items > 0.0) std::snprintf(perItem, sizeof(perItem), "%10.2f", r.nsMedian / r.items);
+    std::printf("[Bench] %-22s %-20s %12.1f ns/op (min %.1f) %s ns/item\n",
+        r.name.c_str(), params, r.nsMedian, r.nsMin, perItem);
+}
+
+static bool writeJson(const char* path, const std::vector<Result>& results) {
+    FILE* f = std::fopen(path, "w");
+    if (!f) return false;
+    char date[32];
+    std::time_t now = std::time(nullptr);
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+#if defined(__VERSION__)
+    const char* compiler = __VERSION__;
+#elif defined(_MSC_VER)
+    const char* compiler = "msvc";
+#else
+    const char* compiler = "unknown";
+#endif
+    std::fprintf(f, "{\n  \"date\": \"%s\",\n  \"compiler\": \"%s\",\n  \"results\": [\n", date, compiler);
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        char perItem[32] = "null";   // no items, e.g. coin collisions without coins
+        if (r.items > 0.0) std::snprintf(perItem, sizeof(perItem), "%.3f", r.nsMedian / r.items);
+        std::fprintf(f, "    { \"name\": \"%s\", \"blocks\": %d, \"coins_per_block\": %d, \"items_per_op\": %.0f, "
+            "\"iterations\": %lld, \"ns_per_op\": %.3f, \"ns_per_op_min\": %.3f, \"ns_per_item\": %s }%s\n",
+            r.name.c_str(), r.blocks, r.coinsPerBlock, r.items, r.iterations, r.nsMedian, r.nsMin,
+            perItem, i + 1 < results.size() ? "," : "");
+    }
+    std::fprintf(f, "  ]\n}\n");
+    std::fclose(f);
+    return true;
+}
+
+int main(int argc, char** argv) {
+    const char* outPath = argc > 1 ? argv[1] : "microbench.json";
+    const char* filter = argc > 2 ? argv[2] : "";
+    const int BLOCK_COUNTS[] = { 16, 64, 256 };
+    const int COIN_DENSITIES[] = { 0, 2, Block::MAX_COINS };
+    const uint32_t SEED = 1234567u;
+
+    std::vector<Result> results;
+    auto wanted = [&](const char* name) { return std::strstr(name, filter) != nullptr; };
+    auto done = [&](Result& r) {
+        report(r);
+        results.push_back(r);
+    };
+
+    if (wanted("AABBIntersect")) {
+        const int COUNT = 4096;
+        std::vector<glm::vec3> mins(COUNT), maxs(COUNT);
+        uint32_t rng = 42u;
+        auto rand01 = [&]() { rng = 1664525u * rng + 1013904223u; return (rng >> 8) * (1.0f / 16777216.0f); };
+        for (int i = 0; i < COUNT; ++i) {
+            mins[i] = glm::vec3(rand01(), rand01(), rand01()) * 20.0f;
+            maxs[i] = mins[i] + glm::vec3(rand01(), rand01(), rand01()) * 3.0f;
+        }
+        Result r;
+        r.name = "AABBIntersect";
+        r.items = COUNT;
+        measure(r, [&] {
+            int hits = 0;
+            for (int i = 0; i < COUNT; ++i) hits += AABBIntersect(mins[i], maxs[i], mins[(i * 7 + 1) % COUNT], maxs[(i * 7 + 1) % COUNT]);
+            gSink += hits;
+        });
+        done(r);
+    }
+
+    if (wanted("createBlock")) {
+        const BlockType TYPES[4] = { BlockType::Normal, BlockType::TurnLeft, BlockType::TurnRight, BlockType::TurnStraight };
+        int index = 0;
+        Result r;
+        r.name = "createBlock";
+        measure(r, [&] {
+            Block block = createBlock(index, TYPES[index & 3], glm::vec3((float)index, 0.0f, 0.0f), (float)((index >> 2) & 3) * 90.0f);
+            gSink += (uint64_t)block.hasFrontWall;
+            index++;
+        });
+        done(r);
+    }
+
+    if (wanted("Player::removeRootMotion")) {
+        Player player;
+        player.sliding = true;
+        player.slideRootInitialized = true;
+        player.slideRootCurrent = glm::vec3(0.4f, 0.0f, 1.2f);
+        std::vector<glm::mat4> bones(64, glm::mat4(1.0f));   // about the player rig's bone count
+        Result r;
+        r.name = "Player::removeRootMotion";
+        r.items = (double)bones.size();
+        measure(r, [&] {
+            std::vector<glm::mat4> out = player.removeRootMotion(bones);
+            gSink += (uint64_t)out[0][3][0];
+        });
+        done(r);
+    }
+
+    for (int blocks : BLOCK_COUNTS) {
+        if (wanted("generateNextBlock")) {
+            World w;
+            WorldBench::build(w, blocks, SEED);
+            Result r;
+            r.name = "generateNextBlock";
+            r.blocks = blocks;
+            r.items = blocks;
+            measure(r, [&] { WorldBench::generate(w, blocks); });
+            r.nsMedian /= blocks;   // reported per generated block
+            r.nsMin /= blocks;
+            r.items = 1.0;
+            done(r);
+        }
+
+        if (wanted("updateBlockGeneration")) {
+            // the player moves one block forward per call, so each call also drops one block
+            // behind and generates one ahead. The next block's center is exactly one block from
+            // the current one (block positions are built from exact orientation tables); if the
+            // lookup ever stops advancing, the calls measured are no-ops and the case is dropped.
+            World w;
+            WorldBench::build(w, blocks, SEED);
+            WorldBench::updateGeneration(w);
+            Result r;
+            r.name = "updateBlockGeneration";
+            r.blocks = blocks;
+            long long calls = 0;
+            int firstBlock = w.playerBlock;
+            measure(r, [&] {
+                const Block* next = w.findBlock(w.playerBlock + 1);
+                if (next) w.player.pos = next->centerPos;
+                WorldBench::updateGeneration(w);
+                gSink += (uint64_t)w.playerBlock;
+                calls++;
+            });
+            if (w.playerBlock - firstBlock == calls) done(r);
+            else std::fprintf(stderr, "[Bench] updateBlockGeneration stalled at block %d after %lld calls, not reported\n",
+                w.playerBlock, calls);
+        }
+
+        for (int coins : COIN_DENSITIES) {
+            World w;
+            WorldBench::build(w, blocks, SEED);
+            setCoinDensity(w, coins);
+
+            if (wanted("checkBlockCollisions") && coins == 0) {
+                Result r;
+                r.name = "checkBlockCollisions";
+                r.blocks = blocks;
+                r.items = (double)w.blocks.size();
+                measure(r, [&] { WorldBench::blockCollisions(w); gSink += (uint64_t)w.hp; });
+                done(r);
+            }
+
+            if (wanted("checkCoinCollisions")) {
+                Result r;
+                r.name = "checkCoinCollisions";
+                r.blocks = blocks;
+                r.coinsPerBlock = coins;
+                r.items = (double)(w.blocks.size() * coins);
+                measure(r, [&] { WorldBench::coinCollisions(w); gSink += (uint64_t)w.coinCount; });
+                done(r);
+            }
+
+            if (wanted("buildDrawList")) {
+                DrawListBench bench;
+                RenderQueue queue;
+                Result r;
+                r.name = "buildDrawList";
+                r.blocks = blocks;
+                r.coinsPerBlock = coins;
+                r.items = bench.build(w, queue);
+                measure(r, [&] { gSink += (uint64_t)bench.build(w, queue); });
+                done(r);
+            }
+        }
+    }
+
+    if (results.empty()) {
+        std::fprintf(stderr, "no benchmark matches '%s'\n", filter);
+        return 1;
+    }
+    if (!writeJson(outPath, results)) {
+        std::fprintf(stderr, "cannot write %s\n", outPath);
+        return 1;
+    }
+    std::printf("[Bench] %zu results written to %s\n", results.size(), outPath);
+    return 0;
+}
@@ -0,0 +1,179 @@
+// Aggregates run logs (run_log.h) into percentiles: coins, block reached and length of each
+// run, and the speed and frame-time samples taken during them. Logs are streamed in fixed
+// chunks and every quantity goes into a fixed-width histogram, so memory stays the same
+// however many logs, or however long ones, are read.
+//
+//   g++ -O2 -std=c++17 -I.. run_stats.cpp -o run_stats
+//   ./run_stats [--live] runs.trlog [more.trlog ...]
+//
+// --live leaves out replays and fixed-step (headless or benchmark) runs.
+#include "../run_log.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Samples in [0, limit) counted in bins of limit / bins; larger ones land in the last bin.
+// Percentiles are nearest-rank and accurate to one bin.
+struct Histogram {
+    const char* name;
+    double width;
+    std::vector<uint64_t> counts;
+    uint64_t total = 0;
+    double sum = 0.0, max = 0.0;
+
+    Histogram(const char* label, double limit, int bins) : name(label), width(limit / bins), counts(bins, 0) {}
+
+    void add(double v) {
+        if (v < 0.0) v = 0.0;
+        size_t bin = std::min((size_t)(v / width), counts.size() - 1);
+        counts[bin]++;
+        total++;
+        sum += v;
+        max = std::max(max, v);
+    }
+
+    double percentile(double p) const {
+        if (total == 0) return 0.0;
+        uint64_t rank = (uint64_t)(p / 100.0 * (double)(total - 1) + 0.5) + 1, seen = 0;
+        for (size_t i = 0; i < counts.size(); ++i) {
+            seen += counts[i];
+            if (seen >= rank) return std::min((i + 0.5) * width, max);
+        }
+        return max;
+    }
+
+    void print() const {
+        if (total == 0) {
+            std::printf("  %-16s %10s\n", name, "-");
+            return;
+        }
+        std::printf("  %-16s %10llu %9.2f %9.2f %9.2f %9.2f %9.2f\n", name, (unsigned long long)total,
+            sum / (double)total, percentile(50.0), percentile(90.0), percentile(99.0), max);
+    }
+};
+
+struct Totals {
+    int files = 0;
+    uint64_t records = 0;
+    uint64_t runs = 0, finished = 0, abandoned = 0;
+    uint64_t coins = 0, hits = 0;
+    uint64_t qualitySteps = 0;
+    float lowestScale = 1.0f;
+    float lowestShadows = 0.0f;   // shadow map resolution, 0 = the governor never stepped
+    double seconds = 0.0;
+    int bestCoins = 0, bestBlock = 0;
+    float bestTime = 0.0f;
+
+    Histogram runCoins{ "coins/run", 1000.0, 1000 };
+    Histogram runBlocks{ "blocks/run", 10000.0, 10000 };
+    Histogram runSeconds{ "run seconds", 3600.0, 36000 };
+    Histogram speed{ "speed", 10.0, 1000 };
+    Histogram cpuMs{ "frame CPU ms", 250.0, 25000 };
+    Histogram gpuMs{ "frame GPU ms", 250.0, 25000 };
+    Histogram wallMs{ "frame wall ms", 250.0, 25000 };
+};
+
+static bool readLog(const char* path, bool liveOnly, Totals& t) {
+    FILE* f = std::fopen(path, "rb");
+    if (!f) {
+        std::fprintf(stderr, "[RunStats] cannot open %s\n", path);
+        return false;
+    }
+    unsigned char raw[RunLog::HEADER_SIZE];
+    RunLogHeader header;
+    bool ok = std::fread(raw, 1, sizeof(raw), f) == sizeof(raw);
+    std::memcpy(&header, raw, sizeof(header));
+    if (!ok || header.magic != RunLog::MAGIC || header.recordSize != sizeof(RunLogRecord)) {
+        std::fprintf(stderr, "[RunStats] %s is not a run log\n", path);
+        std::fclose(f);
+        return false;
+    }
+    if (header.version != RunLog::VERSION) {
+        std::fprintf(stderr, "[RunStats] %s is run log version %u, expected %u\n", path, header.version, RunLog::VERSION);
+        std::fclose(f);
+        return false;
+    }
+    t.files++;
+    t.bestCoins = std::max(t.bestCoins, (int)header.bestCoins);
+    t.bestBlock = std::max(t.bestBlock, (int)header.bestBlock);
+    t.bestTime = std::max(t.bestTime, header.bestTime);
+
+    const uint32_t skipped = liveOnly ? (RUN_LOG_REPLAY | RUN_LOG_FIXED_STEP) : 0u;
+    static RunLogRecord chunk[4096];
+    uint64_t left = header.count;
+    while (left > 0) {
+        size_t want = (size_t)std::min<uint64_t>(left, sizeof(chunk) / sizeof(chunk[0]));
+        size_t got = std::fread(chunk, sizeof(RunLogRecord), want, f);
+        left -= got;
+        t.records += got;
+        for (size_t i = 0; i < got; ++i) {
+            const RunLogRecord& r = chunk[i];
+            if (r.flags & skipped) continue;
+            switch ((RunLogType)r.type) {
+            case RunLogType::RunStart: t.runs++; break;
+            case RunLogType::Coin: t.coins++; break;
+            case RunLogType::Hit: t.hits++; break;
+            case RunLogType::Speed: t.speed.add(r.a); break;
+            case RunLogType::FrameTime:
+                t.cpuMs.add(r.a);
+                t.gpuMs.add(r.b);
+                t.wallMs.add(r.c);
+                break;
+            case RunLogType::RunEnd:
+                if (r.flags & RUN_LOG_ABANDONED) t.abandoned++;
+                else t.finished++;
+                t.seconds += r.time;
+                t.runCoins.add(r.a);
+                t.runBlocks.add(r.b);
+                t.runSeconds.add(r.time);
+                break;
+            case RunLogType::Quality:
+                t.qualitySteps++;
+                t.lowestShadows = t.lowestShadows > 0.0f ? std::min(t.lowestShadows, r.c) : r.c;
+                break;
+            case RunLogType::RenderScale: t.lowestScale = std::min(t.lowestScale, r.a); break;
+            }
+        }
+        if (got < want) {
+            std::fprintf(stderr, "[RunStats] %s is truncated\n", path);
+            break;
+        }
+    }
+    std::fclose(f);
+    return true;
+}
+
+int main(int argc, char** argv) {
+    bool liveOnly = false;
+    std::vector<const char*> paths;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--live") == 0) liveOnly = true;
+        else paths.push_back(argv[i]);
+    }
+    if (paths.empty()) {
+        std::fprintf(stderr, "usage: %s [--live] log [log ...]\n", argv[0]);
+        return 1;
+    }
+
+    Totals t;
+    for (const char* path : paths) readLog(path, liveOnly, t);
+    if (t.files == 0) return 1;
+
+    std::printf("[RunStats] %d logs, %llu records: %llu runs (%llu finished, %llu abandoned), %.1f min played\n",
+        t.files, (unsigned long long)t.records, (unsigned long long)t.runs, (unsigned long long)t.finished,
+        (unsigned long long)t.abandoned, t.seconds / 60.0);
+    std::printf("[RunStats] %llu coins (%.1f per minute), %llu obstacle hits\n", (unsigned long long)t.coins,
+        t.seconds > 0.0 ? t.coins * 60.0 / t.seconds : 0.0, (unsigned long long)t.hits);
+    std::printf("[RunStats] %llu quality governor steps, lowest render scale %.2f", (unsigned long long)t.qualitySteps,
+        t.lowestScale);
+    if (t.lowestShadows > 0.0f) std::printf(", smallest shadow maps %.0fx%.0f", t.lowestShadows, t.lowestShadows);
+    std::printf("\n");
+    std::printf("[RunStats] best: %d coins, block %d, %.1f s\n", t.bestCoins, t.bestBlock, t.bestTime);
+    std::printf("  %-16s %10s %9s %9s %9s %9s %9s\n", "", "samples", "mean", "p50", "p90", "p99", "max");
+    const Histogram* rows[] = { &t.runCoins, &t.runBlocks, &t.runSeconds, &t.speed, &t.cpuMs, &t.gpuMs, &t.wallMs };
+    for (const Histogram* h : rows) h->print();
+    return 0;
+}
@@ -0,0 +1,58 @@
+// Headless throughput check for the batched simulation: steps N worlds with random actions
+// and reports steps per second, episodes finished and the mean reward.
+//
+//   g++ -O2 -std=c++17 -I.. -I<glm include dir> sim_batch.cpp -o sim_batch -pthread
+//   ./sim_batch [worlds] [steps] [threads]
+#include "../world_batch.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+int main(int argc, char** argv) {
+    int worlds = argc > 1 ? std::atoi(argv[1]) : 4096;
+    int steps = argc > 2 ? std::atoi(argv[2]) : 1000;
+    int threads = argc > 3 ? std::atoi(argv[3]) : (int)std::thread::hardware_concurrency();
+    if (worlds <= 0 || steps <= 0 || threads <= 0) {
+        std::fprintf(stderr, "usage: %s [worlds] [steps] [threads]\n", argv[0]);
+        return 1;
+    }
+
+    WorldBatch batch;
+    batch.init(worlds, threads - 1, 1234567u);
+
+    std::vector<WorldAction> actions(worlds);
+    std::vector<float> observations((size_t)worlds * WorldBatch::OBS_SIZE);
+    std::vector<float> rewards(worlds);
+    std::vector<uint8_t> dones(worlds);
+    batch.observe(observations.data());
+
+    const uint32_t buttons[4] = { INPUT_JUMP, INPUT_SLIDE, INPUT_LEFT, INPUT_RIGHT };
+    uint32_t rng = 42u;
+    double rewardSum = 0.0;
+    long long episodes = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int s = 0; s < steps; ++s) {
+        for (auto& a : actions) {
+            rng = 1664525u * rng + 1013904223u;
+            uint32_t r = rng >> 8;
+            // a button roughly every 16 steps
+            a.buttons = (r & 15) == 0 ? buttons[(r >> 4) & 3] : 0u;
+            a.lateral = (float)((r >> 6) & 15) / 7.5f - 1.0f;
+        }
+        batch.step(actions.data(), observations.data(), rewards.data(), dones.data());
+        for (int i = 0; i < worlds; ++i) {
+            rewardSum += rewards[i];
+            episodes += dones[i];
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    batch.shutdown();
+
+    double total = (double)worlds * steps;
+    std::printf("[WorldBatch] %.0f steps in %.3f s: %.2f M steps/s, %lld episodes, mean reward %.4f per step\n",
+        total, seconds, total / seconds * 1e-6, episodes, rewardSum / total);
+    return 0;
+}
@@ -0,0 +1,62 @@
+#ifndef VIEWPORT_STATE_H
+#define VIEWPORT_STATE_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "camera_rig.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Output size, projection and dynamic resolution. The projection only changes on resize;
+// the scene is rendered at renderScale of the output size and upscaled afterwards. The
+// scale itself is chosen by the quality governor.
+class ViewportState {
+public:
+    float minScale = 0.5f;
+    float maxScale = 1.0f;
+
+    void init(int w, int h, const CameraLens& baseLens) {
+        lensState = baseLens;
+        resize(w, h);
+    }
+
+    void resize(int w, int h) {
+        if (w <= 0 || h <= 0) return;   // minimized: keep the last valid state
+        width = w;
+        height = h;
+        lensState.aspect = (float)w / (float)h;
+        proj = glm::perspective(lensState.fovY, lensState.aspect, lensState.zNear, lensState.zFar);
+        revision++;
+    }
+
+    // Returns true when the scene size changed.
+    bool setScale(float s) {
+        s = std::fmax(minScale, std::fmin(maxScale, s));
+        if (std::fabs(s - scale) < 1e-3f) return false;
+        scale = s;
+        revision++;
+        return true;
+    }
+
+    const glm::mat4& projection() const { return proj; }
+    const CameraLens& lens() const { return lensState; }
+    int outputWidth() const { return width; }
+    int outputHeight() const { return height; }
+    int sceneWidth() const { return std::max(1, (int)std::lround(width * scale)); }
+    int sceneHeight() const { return std::max(1, (int)std::lround(height * scale)); }
+    bool scaled() const { return scale < 0.999f; }
+    float renderScale() const { return scale; }
+    // bumped whenever the projection or the scene size changes
+    unsigned int changes() const { return revision; }
+
+private:
+    CameraLens lensState;
+    glm::mat4 proj{ 1.0f };
+    int width = 1, height = 1;
+    float scale = 1.0f;
+    unsigned int revision = 0;
+};
+
+#endif
@@ -0,0 +1,86 @@
+#ifndef WORKER_GROUP_H
+#define WORKER_GROUP_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Persistent helper threads for splitting one loop across cores. The calling thread works
+// too, so run() returns once every index has been processed.
+class WorkerGroup {
+public:
+    void start(int helperCount) {
+        for (int i = 0; i < helperCount; ++i)
+            threads.emplace_back([this] { workerLoop(); });
+    }
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            quit = true;
+        }
+        wake.notify_all();
+        for (auto& t : threads) t.join();
+        threads.clear();
+    }
+
+    ~WorkerGroup() { if (!threads.empty()) stop(); }
+
+    void run(int count, const std::function<void(int)>& fn) {
+        if (threads.empty() || count <= 1) {
+            for (int i = 0; i < count; ++i) fn(i);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job = &fn;
+            jobCount = count;
+            next = 0;
+            active = (int)threads.size();
+            generation++;
+        }
+        wake.notify_all();
+        drain();
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this] { return active == 0; });
+        job = nullptr;
+    }
+
+    int size() const { return (int)threads.size() + 1; }
+
+private:
+    void drain() {
+        for (int i = next.fetch_add(1); i < jobCount; i = next.fetch_add(1))
+            (*job)(i);
+    }
+
+    void workerLoop() {
+        unsigned int seen = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&] { return quit || generation != seen; });
+                if (quit) return;
+                seen = generation;
+            }
+            drain();
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--active == 0) done.notify_one();
+        }
+    }
+
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable wake, done;
+    const std::function<void(int)>* job = nullptr;
+    int jobCount = 0;
+    std::atomic<int> next{ 0 };
+    int active = 0;
+    unsigned int generation = 0;
+    bool quit = false;
+};
+
+#endif
@@ -0,0 +1,187 @@
+#ifndef WORLD_BATCH_H
+#define WORLD_BATCH_H
+
+#include "game_world.h"
+#include "worker_group.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+// One agent's input for a step: INPUT_* buttons pressed this step (jump, slide, turns) and the
+// sideways steering value the game reads from the mouse.
+struct WorldAction {
+    uint32_t buttons = 0;
+    float lateral = 0.0f;
+};
+
+// Steps many independent Worlds in lockstep for bots and training, without a window or GL.
+// Each step takes one action per world and writes a fixed-size observation, a reward and a
+// done flag per world into caller-owned arrays. A finished episode restarts at once with the
+// next seed, so the observation written with done = 1 is already the first one of the new
+// episode. Worlds are split into contiguous chunks over a WorkerGroup; a world is only ever
+// touched by one thread per step, and steady-state stepping does not allocate.
+//
+// Observation layout (OBS_SIZE floats per world):
+//   [0..7]  player: lateral offset in its block (-1..1), progress through the block (-1..1),
+//           height, vertical speed / jump speed, on ground, sliding, speed / max speed,
+//           heading error to the block's direction in quarter turns
+//   then LOOKAHEAD blocks from the player's block on, 4 floats each: turn (-1 left, 1 right,
+//           0 none), obstacle (0 none, 1 jump wall, 2 slide gate), fraction of coins left,
+//           mean lateral offset of the remaining coins (-1..1)
+class WorldBatch {
+public:
+    static const int OBS_PLAYER = 8;
+    static const int LOOKAHEAD = 5;
+    static const int OBS_PER_BLOCK = 4;
+    static const int OBS_SIZE = OBS_PLAYER + LOOKAHEAD * OBS_PER_BLOCK;
+
+    float stepTime = 1.0f / 60.0f;   // simulated seconds per step
+    float coinReward = 1.0f;
+    float blockReward = 0.1f;        // per block of progress
+    float deathReward = -10.0f;
+    int maxEpisodeSteps = 60 * 60 * 5;   // truncates runs stuck against a wall
+
+    // Just enough window for the lookahead; the budget never limits it.
+    static StreamingConfig trainingConfig() {
+        StreamingConfig config;
+        config.aheadDistance = (LOOKAHEAD + 2) * Block::SIZE;
+        config.behindDistance = 2.0f * Block::SIZE;
+        config.minBlocksAhead = LOOKAHEAD + 2;
+        config.memoryBudget = (size_t)1 << 30;
+        return config;
+    }
+
+    void init(int count, int helperThreads, uint32_t seed, const StreamingConfig& config = trainingConfig()) {
+        baseSeed = seed;
+        envs.clear();
+        envs.resize(count);
+        for (int i = 0; i < count; ++i) {
+            envs[i].world.streaming.config = config;
+            startEpisode(i);
+        }
+        workers.start(helperThreads);
+        // a few chunks per thread so uneven worlds (generation, resets) balance out
+        chunkSize = std::max(1, count / (workers.size() * 4));
+        chunks = (count + chunkSize - 1) / chunkSize;
+        std::cout << "[WorldBatch] " << count << " worlds, stepping on " << workers.size() << " threads" << std::endl;
+    }
+
+    void shutdown() { workers.stop(); }
+
+    // actions: size() entries. observations: size() * OBS_SIZE floats, rewards and dones:
+    // size() entries each.
+    void step(const WorldAction* actions, float* observations, float* rewards, uint8_t* dones) {
+        workers.run(chunks, [&](int chunk) {
+            int end = std::min((chunk + 1) * chunkSize, size());
+            for (int i = chunk * chunkSize; i < end; ++i)
+                stepOne(i, actions[i], observations + (size_t)i * OBS_SIZE, rewards[i], dones[i]);
+        });
+    }
+
+    // Observations of the current state, e.g. before the first step.
+    void observe(float* observations) const {
+        for (int i = 0; i < size(); ++i) writeObservation(envs[i].world, observations + (size_t)i * OBS_SIZE);
+    }
+
+    int size() const { return (int)envs.size(); }
+    const World& world(int i) const { return envs[i].world; }
+    int episodes(int i) const { return envs[i].episode; }
+
+private:
+    struct Env {
+        World world;
+        int episode = -1;
+        int steps = 0;
+        int lastBlock = 0;
+        int lastCoins = 0;
+    };
+
+    // Distinct, reproducible level per world and episode.
+    uint32_t episodeSeed(int i, int episode) const {
+        uint32_t h = baseSeed ^ (uint32_t)i * 0x9E3779B9u ^ (uint32_t)episode * 0x85EBCA6Bu;
+        h ^= h >> 16; h *= 0x7FEB352Du;
+        h ^= h >> 15; h *= 0x846CA68Bu;
+        h ^= h >> 16;
+        return h ? h : 1u;
+    }
+
+    void startEpisode(int i) {
+        Env& env = envs[i];
+        env.episode++;
+        env.world.reset(episodeSeed(i, env.episode));
+        env.steps = 0;
+        env.lastBlock = 0;
+        env.lastCoins = 0;
+    }
+
+    void stepOne(int i, const WorldAction& action, float* obs, float& reward, uint8_t& done) {
+        Env& env = envs[i];
+        World& w = env.world;
+        w.step(stepTime, action.buttons, action.lateral);
+        env.steps++;
+
+        int block = std::max(w.playerBlock, 0);
+        reward = (w.coinCount - env.lastCoins) * coinReward + (block - env.lastBlock) * blockReward;
+        env.lastCoins = w.coinCount;
+        env.lastBlock = block;
+        if (w.gameOver) reward += deathReward;
+
+        done = (w.gameOver || env.steps >= maxEpisodeSteps) ? 1 : 0;
+        if (done) startEpisode(i);
+        writeObservation(w, obs);
+    }
+
+    static void writeObservation(const World& w, float* obs) {
+        const Player& p = w.player;
+        const float half = Block::SIZE * 0.5f;
+        const Block* current = w.findBlock(std::max(w.playerBlock, 0));
+
+        float lateral = 0.0f, progress = 0.0f, heading = 0.0f;
+        if (current) {
+            glm::vec3 d = p.pos - current->centerPos;
+            lateral = glm::dot(d, getRightFromYaw(current->yaw)) / half;
+            progress = glm::dot(d, getDirectionFromYaw(current->yaw)) / half;
+            float err = std::fmod(p.yaw - current->yaw + 540.0f, 360.0f) - 180.0f;
+            heading = err / 90.0f;
+        }
+        obs[0] = lateral;
+        obs[1] = progress;
+        obs[2] = p.pos.y;
+        obs[3] = p.vel.y / p.jumpSpeed;
+        obs[4] = p.onGround ? 1.0f : 0.0f;
+        obs[5] = p.sliding ? 1.0f : 0.0f;
+        obs[6] = w.speed / w.maxSpeed;
+        obs[7] = heading;
+
+        for (int k = 0; k < LOOKAHEAD; ++k) {
+            float* o = obs + OBS_PLAYER + k * OBS_PER_BLOCK;
+            const Block* b = current ? w.findBlock(current->blockIndex + k) : nullptr;
+            if (!b) {
+                o[0] = o[1] = o[2] = o[3] = 0.0f;
+                continue;
+            }
+            o[0] = b->type == BlockType::TurnLeft ? -1.0f : b->type == BlockType::TurnRight ? 1.0f : 0.0f;
+            o[1] = !b->hasObstacle ? 0.0f : b->obstacle.type == ObsType::JumpWall ? 1.0f : 2.0f;
+
+            glm::vec3 right = getRightFromYaw(b->yaw);
+            int left = 0;
+            float offset = 0.0f;
+            for (const auto& coin : b->coins) {
+                if (coin.collected) continue;
+                left++;
+                offset += glm::dot(coin.pos - b->centerPos, right);
+            }
+            o[2] = b->coins.empty() ? 0.0f : (float)left / (float)b->coins.size();
+            o[3] = left > 0 ? offset / (left * half) : 0.0f;
+        }
+    }
+
+    std::vector<Env> envs;
+    WorkerGroup workers;
+    uint32_t baseSeed = 1;
+    int chunkSize = 1, chunks = 0;
+};
+
+#endif